@@ -0,0 +1,100 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include "Bytecode.hpp"
+#include "Precedence.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+/// \file
+///
+/// \brief A minimal microbenchmark harness for the Latitude VM.
+///
+/// Each benchmark is a function which performs a requested number of
+/// iterations of some operation. The harness calibrates the iteration
+/// count so that a single sample runs for a measurable amount of
+/// time, then takes several samples and reports the median, minimum,
+/// and maximum cost per iteration.
+
+/// The VM used by the benchmarks. The standard library has already
+/// been loaded into it.
+extern VMState* benchVM;
+
+/// The global object of #benchVM.
+extern ObjectPtr* benchGlobal;
+
+/// \brief A single named benchmark.
+struct Benchmark {
+    /// The name of the benchmark, which should be stable across
+    /// commits so that results can be compared.
+    std::string name;
+    /// Runs the given number of iterations of the benchmark.
+    std::function<void(long)> run;
+};
+
+/// \return every registered benchmark
+std::vector<Benchmark>& benchmarks();
+
+/// \brief Registers a benchmark when constructed. Instances are
+/// created by the #BENCHMARK macro.
+struct BenchRegistrar {
+    BenchRegistrar(std::string name, std::function<void(long)> run);
+};
+
+/// Stops the clock for the current sample, so that work which is
+/// not part of the measured operation (such as building a large heap)
+/// can be excluded. Every call must be followed by a call to
+/// #resumeTiming before the benchmark returns.
+void pauseTiming();
+
+/// Restarts the clock after a call to #pauseTiming.
+void resumeTiming();
+
+/// Prevents the compiler from optimizing away a computed value.
+///
+/// \param value the value
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+/// Evaluates a string of Latitude code in a scope derived from the
+/// global object and runs the VM until the code completes.
+///
+/// \param code the Latitude code
+void runLatitude(const std::string& code);
+
+/// Returns a benchmark body which runs the Latitude statement `body`,
+/// the requested number of times, in a scope in which the Latitude
+/// statements `setup` have already been run. The body is run by an
+/// unrolled `times do` loop, so the `latitude/empty-loop` benchmark
+/// measures the loop overhead included in every such result.
+///
+/// \param setup Latitude statements run once per sample
+/// \param body a Latitude statement run once per iteration
+/// \return the benchmark body
+std::function<void(long)> latitudeLoop(std::string setup, std::string body);
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+
+/// Defines and registers a benchmark. The macro should be followed by
+/// a function body, in which `iterations` is the number of iterations
+/// to perform.
+#define BENCHMARK(name)                                                 \
+    static void BENCH_CONCAT(bench_, __LINE__)(long iterations);        \
+    static BenchRegistrar BENCH_CONCAT(benchRegistrar_, __LINE__)       \
+        { name, BENCH_CONCAT(bench_, __LINE__) };                       \
+    static void BENCH_CONCAT(bench_, __LINE__)(long iterations)
+
+/// Registers a benchmark which runs Latitude code, as though by
+/// #latitudeLoop.
+#define LATITUDE_BENCHMARK(name, setup, body)                           \
+    static BenchRegistrar BENCH_CONCAT(benchRegistrar_, __LINE__)       \
+        { name, latitudeLoop(setup, body) };
+
+#endif // BENCH_HPP
@@ -0,0 +1,41 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#include "bench.hpp"
+#include "GC.hpp"
+#include "Symbol.hpp"
+
+namespace {
+
+    // Collects a heap containing the given number of extra live
+    // objects, in addition to the standard library.
+    void collectWithHeap(long iterations, long size) {
+        pauseTiming();
+        ObjectPtr root = clone(benchVM->reader.lit[Lit::OBJECT]);
+        for (long i = 0; i < size; i++)
+            root->put(Symbols::get()["bench" + std::to_string(i)], clone(root));
+        benchVM->state.lex.push(root);
+        GC::get().garbageCollect(*benchVM);
+        resumeTiming();
+        for (long i = 0; i < iterations; i++)
+            keep(GC::get().garbageCollect(*benchVM));
+        pauseTiming();
+        benchVM->state.lex.pop();
+        root = nullptr;
+        GC::get().garbageCollect(*benchVM);
+        resumeTiming();
+    }
+
+}
+
+BENCHMARK("gc/collect/heap-000000") {
+    collectWithHeap(iterations, 0);
+}
+
+BENCHMARK("gc/collect/heap-010000") {
+    collectWithHeap(iterations, 10000);
+}
+
+BENCHMARK("gc/collect/heap-100000") {
+    collectWithHeap(iterations, 100000);
+}
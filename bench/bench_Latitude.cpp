@@ -0,0 +1,109 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#include "bench.hpp"
+
+namespace {
+
+    // Returns the source of a nonempty array literal (or, if dict is
+    // true, a dictionary literal) with the given number of numeric
+    // elements.
+    std::string literalOfSize(long size, bool dict) {
+        std::string result = "[";
+        for (long i = 0; i < size; i++) {
+            std::string elem = std::to_string(i);
+            result += (i > 0 ? ", " : "") + (dict ? elem + " => " + elem : elem);
+        }
+        return result + "]";
+    }
+
+}
+
+// The loop itself, for comparison with everything below.
+LATITUDE_BENCHMARK("latitude/empty-loop",
+                   "",
+                   "Nil.")
+
+LATITUDE_BENCHMARK("latitude/slot-lookup/depth-01",
+                   "a := Object clone. a x := 1.",
+                   "a x.")
+
+LATITUDE_BENCHMARK("latitude/slot-lookup/depth-04",
+                   "a := Object clone. a x := 1. d := a clone clone clone.",
+                   "d x.")
+
+LATITUDE_BENCHMARK("latitude/method-call/no-args",
+                   "f := { Nil. }.",
+                   "f.")
+
+LATITUDE_BENCHMARK("latitude/method-call/two-args",
+                   "f := { $2. }.",
+                   "f (1, 2).")
+
+LATITUDE_BENCHMARK("latitude/clone",
+                   "",
+                   "Object clone.")
+
+LATITUDE_BENCHMARK("latitude/number/add",
+                   "x := 10.",
+                   "x + 1.")
+
+LATITUDE_BENCHMARK("latitude/number/big-mul",
+                   "x := 12345678901234567890.",
+                   "x * x.")
+
+LATITUDE_BENCHMARK("latitude/number/ratio-add",
+                   "x := 1 / 3.",
+                   "x + x.")
+
+LATITUDE_BENCHMARK("latitude/string/concat",
+                   "a := \"abcdefgh\". b := \"ijklmnop\".",
+                   "a ++ b.")
+
+LATITUDE_BENCHMARK("latitude/string/substring-long",
+                   "s := \"\". 500 times do { parent s := s ++ \"a\\u{e9}\". }.",
+                   "s substring (900, 901).")
+
+LATITUDE_BENCHMARK("latitude/string/split-csv",
+                   "s := \"\". 100 times do { parent s := s ++ \"abc,de,,fghij,\". }.",
+                   "s split \",\".")
+
+LATITUDE_BENCHMARK("latitude/string/toUpper-long",
+                   "s := \"\". 100 times do { parent s := s ++ \"Hello, World! \". }.",
+                   "s toUpper.")
+
+LATITUDE_BENCHMARK("latitude/array/pushBack",
+                   "arr := [].",
+                   "arr pushBack: 1.")
+
+LATITUDE_BENCHMARK("latitude/array/nth",
+                   "arr := [1, 2, 3, 4, 5, 6, 7, 8, 9, 10].",
+                   "arr nth 5.")
+
+LATITUDE_BENCHMARK("latitude/array/clone-1000",
+                   "arr := " + literalOfSize(1000, false) + ".",
+                   "arr clone.")
+
+LATITUDE_BENCHMARK("latitude/array/visit-100",
+                   "arr := " + literalOfSize(100, false) + ".",
+                   "arr visit { $1. }.")
+
+LATITUDE_BENCHMARK("latitude/range/visit-100",
+                   "",
+                   "100 times do { $1. }.")
+
+LATITUDE_BENCHMARK("latitude/dict/get",
+                   "d := ['a => 1, 'b => 2, 'c => 3, 'd => 4].",
+                   "d get 'c.")
+
+LATITUDE_BENCHMARK("latitude/dict/clone-1000",
+                   "d := " + literalOfSize(1000, true) + ".",
+                   "d clone.")
+
+LATITUDE_BENCHMARK("latitude/dict/visit-100",
+                   "d := " + literalOfSize(100, true) + ".",
+                   "d visit { $1. }.")
+
+LATITUDE_BENCHMARK("latitude/callCC/escape",
+                   "",
+                   "callCC { $1 call: Nil. }.")
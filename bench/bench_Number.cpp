@@ -0,0 +1,68 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#include "bench.hpp"
+#include "Number.hpp"
+
+namespace {
+
+    Number big() {
+        return Number(Number::bigint("123456789012345678901234567890"));
+    }
+
+    Number ratio() {
+        return Number(Number::ratio(Number::bigint(22), Number::bigint(7)));
+    }
+
+}
+
+BENCHMARK("number/small/add") {
+    Number total { 0L };
+    Number step { 3L };
+    for (long i = 0; i < iterations; i++)
+        total = total + step;
+    keep(total);
+}
+
+BENCHMARK("number/small/mul") {
+    Number total { 1L };
+    Number factor { -1L };
+    for (long i = 0; i < iterations; i++)
+        total = total * factor;
+    keep(total);
+}
+
+BENCHMARK("number/small/overflow") {
+    // Every product overflows into a bigint.
+    Number a { 1L << 40 };
+    for (long i = 0; i < iterations; i++)
+        keep(a * a);
+}
+
+BENCHMARK("number/big/add") {
+    Number a = big();
+    Number b = big();
+    for (long i = 0; i < iterations; i++)
+        keep(a + b);
+}
+
+BENCHMARK("number/big/mul") {
+    Number a = big();
+    Number b = big();
+    for (long i = 0; i < iterations; i++)
+        keep(a * b);
+}
+
+BENCHMARK("number/ratio/add") {
+    Number a = ratio();
+    Number b = ratio();
+    for (long i = 0; i < iterations; i++)
+        keep(a + b);
+}
+
+BENCHMARK("number/ratio/div") {
+    Number a = ratio();
+    Number b = big();
+    for (long i = 0; i < iterations; i++)
+        keep(a / b);
+}
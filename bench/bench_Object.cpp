@@ -0,0 +1,55 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#include "bench.hpp"
+#include "Parents.hpp"
+#include "Proto.hpp"
+#include "Symbol.hpp"
+
+namespace {
+
+    // Looks up a slot which is defined on the root of a parent chain
+    // of the given length.
+    void lookupAtDepth(long iterations, int depth) {
+        pauseTiming();
+        Symbolic name = Symbols::get()["benchSlot"];
+        ObjectPtr root = clone(benchVM->reader.lit[Lit::OBJECT]);
+        root->put(name, root);
+        ObjectPtr leaf = root;
+        for (int i = 1; i < depth; i++)
+            leaf = clone(leaf);
+        resumeTiming();
+        for (long i = 0; i < iterations; i++)
+            keep(objectGet(leaf, name));
+        pauseTiming();
+        root->remove(name);
+        resumeTiming();
+    }
+
+}
+
+BENCHMARK("object/slot-lookup/depth-01") {
+    lookupAtDepth(iterations, 1);
+}
+
+BENCHMARK("object/slot-lookup/depth-04") {
+    lookupAtDepth(iterations, 4);
+}
+
+BENCHMARK("object/slot-lookup/depth-16") {
+    lookupAtDepth(iterations, 16);
+}
+
+BENCHMARK("object/clone") {
+    ObjectPtr object = benchVM->reader.lit[Lit::OBJECT];
+    for (long i = 0; i < iterations; i++)
+        keep(clone(object));
+}
+
+BENCHMARK("object/put") {
+    Symbolic name = Symbols::get()["benchSlot"];
+    ObjectPtr object = clone(benchVM->reader.lit[Lit::OBJECT]);
+    ObjectPtr value = benchVM->reader.lit[Lit::NIL];
+    for (long i = 0; i < iterations; i++)
+        object->put(name, value);
+}
@@ -0,0 +1,28 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#include "bench.hpp"
+#include "Reader.hpp"
+#include "Pathname.hpp"
+
+namespace {
+
+    // The files loaded by std/latitude.lats. Loading the standard
+    // library leaves a compiled copy of each of them behind.
+    const char* const STD_FILES[] = {
+        "latitude", "core", "exception", "flow-control", "arithmetic", "array", "enum", "mixin",
+        "dict", "collection", "args", "protect", "operator", "string", "module"
+    };
+
+}
+
+BENCHMARK("reader/load-latc/std") {
+    std::string pathname = stripFilename(getExecutablePathname());
+    for (long i = 0; i < iterations; i++) {
+        for (const char* name : STD_FILES) {
+            std::ifstream file { pathname + "std/" + name + ".latsc",
+                                 std::ifstream::in | std::ifstream::binary };
+            keep(loadFromFile(file));
+        }
+    }
+}
@@ -0,0 +1,183 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#include "bench.hpp"
+#include "Proto.hpp"
+#include "Reader.hpp"
+#include "Pathname.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+VMState* benchVM;
+ObjectPtr* benchGlobal;
+
+namespace {
+
+    std::unique_ptr<OperatorTable> table;
+
+    std::chrono::steady_clock::time_point pausedAt;
+    std::chrono::steady_clock::duration excluded;
+
+    struct Result {
+        std::string name;
+        long iterations;
+        double median;
+        double min;
+        double max;
+    };
+
+    double secondsFor(const Benchmark& bench, long iterations) {
+        excluded = std::chrono::steady_clock::duration::zero();
+        auto start = std::chrono::steady_clock::now();
+        bench.run(iterations);
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start - excluded).count();
+    }
+
+    Result measure(const Benchmark& bench, int samples, double minTime) {
+        // Calibrate the iteration count so that a single sample takes
+        // at least minTime seconds.
+        long iterations = 1;
+        while (true) {
+            double elapsed = secondsFor(bench, iterations);
+            if ((elapsed >= minTime) || (iterations >= (1L << 30)))
+                break;
+            long factor = (elapsed <= 0) ? 10 : (long)(1.5 * minTime / elapsed) + 1;
+            iterations *= std::min(std::max(factor, 2L), 10L);
+        }
+        std::vector<double> costs;
+        for (int i = 0; i < samples; i++)
+            costs.push_back(secondsFor(bench, iterations) * 1e9 / iterations);
+        std::sort(costs.begin(), costs.end());
+        return { bench.name, iterations, costs[costs.size() / 2], costs.front(), costs.back() };
+    }
+
+    void writeJson(std::ostream& out, const std::vector<Result>& results, int samples) {
+        out << "{\n";
+        out << "  \"version\": 1,\n";
+        out << "  \"samples\": " << samples << ",\n";
+        out << "  \"benchmarks\": [\n";
+        out << std::fixed << std::setprecision(2);
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                << ", \"median_ns\": " << r.median << ", \"min_ns\": " << r.min
+                << ", \"max_ns\": " << r.max << "}";
+            out << ((i + 1 < results.size()) ? ",\n" : "\n");
+        }
+        out << "  ]\n";
+        out << "}\n";
+    }
+
+}
+
+std::vector<Benchmark>& benchmarks() {
+    static std::vector<Benchmark> instance;
+    return instance;
+}
+
+BenchRegistrar::BenchRegistrar(std::string name, std::function<void(long)> run) {
+    benchmarks().push_back({ name, run });
+}
+
+void pauseTiming() {
+    pausedAt = std::chrono::steady_clock::now();
+}
+
+void resumeTiming() {
+    excluded += std::chrono::steady_clock::now() - pausedAt;
+}
+
+void runLatitude(const std::string& code) {
+    eval(*benchVM, *table, code);
+    while (!isIdling(benchVM->state))
+        doOneStep(*benchVM);
+}
+
+std::function<void(long)> latitudeLoop(std::string setup, std::string body) {
+    // Looping is expensive in Latitude, so unroll the loop to keep its
+    // overhead from swamping the body.
+    constexpr long UNROLL = 10;
+    std::string unrolled;
+    for (long i = 0; i < UNROLL; i++)
+        unrolled += body + " ";
+    return [setup, body, unrolled](long iterations) {
+        std::string code = "{ " + setup + " (" + std::to_string(iterations / UNROLL) + ") times do { " +
+            unrolled + "}. ";
+        for (long i = 0; i < iterations % UNROLL; i++)
+            code += body + " ";
+        runLatitude(code + "} call.");
+    };
+}
+
+int main(int argc, char** argv) {
+    std::string filter = "";
+    std::string json = "";
+    int samples = 5;
+    double minTime = 0.05;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--json=", 7) == 0) {
+            json = argv[i] + 7;
+        } else if (std::strncmp(argv[i], "--samples=", 10) == 0) {
+            samples = std::max(1, std::atoi(argv[i] + 10));
+        } else if (std::strncmp(argv[i], "--min-time=", 11) == 0) {
+            minTime = std::atof(argv[i] + 11);
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--filter=<text>] [--json=<file>] [--samples=<n>] [--min-time=<seconds>]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    ObjectPtr global;
+    VMState vm { VMState::createAndInit(&global, argc, argv) };
+    benchVM = &vm;
+    benchGlobal = &global;
+
+    // Load the standard library, just as the runner does.
+    std::string pathname = stripFilename(getExecutablePathname());
+    table.reset(new OperatorTable(getTable(global)));
+    readFile(pathname + "std/latitude.lats", { global, global }, vm, *table);
+    while (!isIdling(vm.state))
+        doOneStep(vm);
+    table.reset(new OperatorTable(getTable(global)));
+    vm.state.lex.push(clone(global));
+    vm.state.dyn.push(clone(global));
+
+    std::vector<Benchmark> selected;
+    for (const Benchmark& bench : benchmarks()) {
+        if (bench.name.find(filter) != std::string::npos)
+            selected.push_back(bench);
+    }
+    std::sort(selected.begin(), selected.end(), [](const Benchmark& a, const Benchmark& b) {
+        return a.name < b.name;
+    });
+
+    std::vector<Result> results;
+    std::cout << std::left << std::setw(36) << "benchmark" << std::right
+              << std::setw(14) << "median ns/op" << std::setw(14) << "min" << std::setw(14) << "max"
+              << std::endl;
+    for (const Benchmark& bench : selected) {
+        Result result = measure(bench, samples, minTime);
+        std::cout << std::left << std::setw(36) << result.name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(14) << result.median
+                  << std::setw(14) << result.min << std::setw(14) << result.max << std::endl;
+        results.push_back(result);
+    }
+
+    if (!json.empty()) {
+        std::ofstream out { json };
+        writeJson(out, results, samples);
+    }
+
+    return 0;
+}
@@ -0,0 +1,227 @@
+#!/usr/bin/python3
+
+### Copyright (c) 2018 Silvio Mayolo
+### See LICENSE.txt for licensing details
+
+# Runs the Latitude benchmark programs in bench/programs/ through the
+# runner and compares their wall time, peak resident set size, and
+# garbage collection count against a stored baseline. Exits with a
+# nonzero status if any program regresses by more than the threshold
+# or if its output changes.
+#
+# Timings depend on the machine, so the baseline records the host it
+# was measured on and the time taken by a fixed calibration workload.
+# Wall and CPU times are compared only against a baseline from the same
+# host, after scaling them by the ratio of the two calibration times to
+# absorb changes in clock speed and load. Against a baseline from any
+# other host, only the output, peak RSS, and collection count are
+# compared.
+#
+# Usage: bench/regress.py [--latitude=<exe>] [--baseline=<file>]
+#                         [--threshold=<fraction>] [--runs=<n>]
+#                         [--filter=<text>] [--update]
+
+import json
+import os
+import platform
+import subprocess
+import sys
+import tempfile
+import time
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+PROGRAM_DIR = os.path.join(BENCH_DIR, "programs")
+
+# The measurements compared against the baseline, with the smallest
+# absolute change in each which is considered significant. Timer and
+# RSS noise on very short runs would otherwise trip the threshold.
+METRICS = [
+    ("wall_s", 0.05),
+    ("cpu_s", 0.05),
+    ("peak_rss_kb", 1024),
+    ("gc_collections", 1),
+]
+
+# The measurements which are scaled by the calibration ratio and which
+# are only meaningful on the host that recorded them.
+TIME_METRICS = {"wall_s", "cpu_s"}
+
+BASELINE_VERSION = 2
+
+def host_id():
+    """Identifies the machine, well enough to tell whether two sets of
+    timings are comparable."""
+    model = platform.processor()
+    try:
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                if line.startswith("model name"):
+                    model = line.partition(":")[2].strip()
+                    break
+    except OSError:
+        pass
+    return "{} {} {} x{}".format(platform.node(), platform.machine(), model, os.cpu_count())
+
+def calibrate(runs):
+    """Times a fixed workload which does not involve Latitude at all,
+    keeping the best of several runs."""
+    best = None
+    for _ in range(runs):
+        start = time.monotonic()
+        total = 0
+        for i in range(2000000):
+            total = (total + i * i) % 1000003
+        elapsed = time.monotonic() - start
+        best = elapsed if best is None else min(best, elapsed)
+    return round(best, 4)
+
+def parse_args(argv):
+    args = {
+        "latitude": os.path.join(BENCH_DIR, "..", "latitude"),
+        "baseline": os.path.join(PROGRAM_DIR, "baseline.json"),
+        "threshold": 0.10,
+        "runs": 3,
+        "filter": "",
+        "update": False,
+    }
+    for arg in argv:
+        if arg == "--update":
+            args["update"] = True
+            continue
+        key, sep, value = arg.partition("=")
+        name = key[2:]
+        if not key.startswith("--") or not sep or name not in args or name == "update":
+            sys.exit("Usage: " + os.path.basename(sys.argv[0]) +
+                     " [--latitude=<exe>] [--baseline=<file>] [--threshold=<fraction>]" +
+                     " [--runs=<n>] [--filter=<text>] [--update]")
+        if name == "threshold":
+            value = float(value)
+        elif name == "runs":
+            value = max(1, int(value))
+        args[name] = value
+    return args
+
+def run_once(latitude, program):
+    """Runs the program once, returning its output and measurements."""
+    with tempfile.TemporaryDirectory() as tmp:
+        log = os.path.join(tmp, "gc.jsonl")
+        with open(os.path.join(tmp, "stdout"), "w+b") as out, \
+             open(os.path.join(tmp, "stderr"), "w+b") as err:
+            start = time.monotonic()
+            proc = subprocess.Popen([latitude, "--gc-log=" + log, program], stdout=out, stderr=err)
+            # Reap the child directly, rather than with Popen.wait, so
+            # that its own resource usage is available.
+            _, status, usage = os.wait4(proc.pid, 0)
+            wall = time.monotonic() - start
+            out.seek(0)
+            err.seek(0)
+            output = out.read().decode(errors="replace")
+            errors = err.read().decode(errors="replace")
+        collections = 0
+        if os.path.exists(log):
+            with open(log) as f:
+                collections = sum(1 for line in f if line.strip())
+    # The runner reports uncaught exceptions but still exits normally.
+    if status != 0 or "***** EXCEPTION *****" in errors:
+        sys.stderr.write(errors)
+        sys.exit("{} failed".format(os.path.basename(program)))
+    return output, {
+        "wall_s": round(wall, 3),
+        "cpu_s": round(usage.ru_utime + usage.ru_stime, 3),
+        "peak_rss_kb": usage.ru_maxrss,
+        "gc_collections": collections,
+    }
+
+def measure(latitude, program, runs):
+    """Runs the program several times, keeping the best of each
+    measurement. Interference from the rest of the system only ever
+    makes a run slower, so the minimum is the most repeatable."""
+    outputs = []
+    samples = []
+    for _ in range(runs):
+        out, sample = run_once(latitude, program)
+        outputs.append(out)
+        samples.append(sample)
+    result = { "output": outputs[0] }
+    for metric, _ in METRICS:
+        result[metric] = min(sample[metric] for sample in samples)
+    return result
+
+def compare(name, current, baseline, threshold, scale):
+    """Returns a list of the ways in which the current result is worse
+    than the baseline. Times are multiplied by scale before comparing,
+    or skipped entirely if scale is None."""
+    failures = []
+    if current["output"] != baseline["output"]:
+        failures.append("{}: output changed".format(name))
+    for metric, slack in METRICS:
+        old = baseline[metric]
+        new = current[metric]
+        if metric in TIME_METRICS:
+            if scale is None:
+                continue
+            new = round(new * scale, 3)
+        if new > old * (1 + threshold) and new - old > slack:
+            failures.append("{}: {} regressed from {} to {} (+{:.1f}%)".format(
+                name, metric, old, new, 100.0 * (new - old) / old if old else float("inf")))
+    return failures
+
+def main():
+    args = parse_args(sys.argv[1:])
+    programs = sorted(name[:-4] for name in os.listdir(PROGRAM_DIR)
+                      if name.endswith(".lat") and args["filter"] in name)
+
+    baseline = { "version": BASELINE_VERSION, "programs": {} }
+    if os.path.exists(args["baseline"]):
+        with open(args["baseline"]) as f:
+            baseline = json.load(f)
+
+    host = host_id()
+    calibration = calibrate(args["runs"])
+    scale = None
+    if baseline.get("version") != BASELINE_VERSION:
+        if not args["update"]:
+            print("Baseline is from an older version of this script; run with --update to replace it")
+        baseline = { "version": BASELINE_VERSION, "programs": {} }
+    elif args["update"]:
+        pass
+    elif baseline.get("host") != host:
+        print("Baseline was recorded on another host ({}); not comparing times".format(
+            baseline.get("host")))
+    else:
+        scale = baseline["calibration_s"] / calibration
+        print("Calibration {:.4f}s against {:.4f}s in the baseline; scaling times by {:.3f}".format(
+            calibration, baseline["calibration_s"], scale))
+
+    results = {}
+    failures = []
+    print("{:<16}{:>10}{:>10}{:>14}{:>8}".format("program", "wall s", "cpu s", "peak RSS KB", "GCs"))
+    for name in programs:
+        current = measure(args["latitude"], os.path.join(PROGRAM_DIR, name + ".lat"), args["runs"])
+        results[name] = current
+        print("{:<16}{:>10.3f}{:>10.3f}{:>14}{:>8}".format(name, current["wall_s"], current["cpu_s"],
+                                                           current["peak_rss_kb"], current["gc_collections"]))
+        if name in baseline["programs"] and not args["update"]:
+            failures += compare(name, current, baseline["programs"][name], args["threshold"], scale)
+        elif not args["update"]:
+            print("  (no baseline for {})".format(name))
+
+    if args["update"]:
+        # Timings from different hosts cannot be mixed in one baseline.
+        if baseline.get("host") != host:
+            baseline["programs"] = {}
+        baseline["host"] = host
+        baseline["calibration_s"] = calibration
+        baseline["programs"].update(results)
+        with open(args["baseline"], "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("Baseline written to " + args["baseline"])
+        return 0
+
+    for failure in failures:
+        print("REGRESSION " + failure)
+    return 1 if failures else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
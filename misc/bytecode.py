@@ -104,6 +104,11 @@ INSTRUCTION_TABLE = {
     0x34: ("arr", [ArgType.LONG]),
     0x35: ("dict", [ArgType.LONG]),
     0x36: ("xxx", [ArgType.LONG]),
+    0x37: ("goto", []),
+    0x38: ("mswap", []),
+    0x39: ("argld", [ArgType.LONG]),
+    0x3A: ("rtrvr", [ArgType.LONG]),
+    0x3B: ("callr", [ArgType.LONG]),
 }
 
 class Register:
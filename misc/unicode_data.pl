@@ -13,26 +13,48 @@ my @classes = qw{
     Cf Cs Co Cn
 };
 
+# Both the general categories and the case mappings are stored in
+# two-level tables. The code points are divided into blocks of
+# BLOCK_SIZE, identical blocks are stored only once, and the first
+# level maps each block of code points to the stored block holding its
+# values. Most blocks are either unassigned or uniform, so the tables
+# stay small, and every lookup takes constant time.
+use constant {
+    BLOCK_SHIFT => 8,
+    BLOCK_SIZE  => 256,
+    CODE_POINTS => 0x110000,
+};
+
+my %class_index;
+@class_index{@classes} = 0 .. $#classes;
+
+# One byte per code point, holding the index of its category. A code
+# point which is not listed belongs to the same run as the code point
+# before it, as do the code points between the first and last
+# characters of a range.
+my $class_data = chr($class_index{Cn}) x CODE_POINTS;
+
+# One entry per code point, holding the index of its case record. Each
+# record is the difference between the code point and its lowercase,
+# uppercase, and title case equivalents, in that order, and record 0
+# maps every code point to itself.
+my @case_data = (0) x CODE_POINTS;
+my @case_records = ('0, 0, 0');
+my %case_index = ('0, 0, 0' => 0);
+
 my $curr = '';
-my $start;
-my %classes;
-my @data;
-my @char_data;
+my $start = 0;
 
 open my $fh, '<', '../misc/uni/UnicodeData.txt';
 while (<$fh>) {
     my @line = split /;/;
+    my $codepoint = hex $line[0];
     if ($curr ne $line[2]) {
         if ($curr ne '') {
-            my %value = (
-                start => $start  ,
-                end   => $line[0],
-                class => $curr
-                );
-            push @data, \%value;
-            ++$classes{$curr};
+            substr($class_data, $start, $codepoint - $start) =
+                chr($class_index{$curr}) x ($codepoint - $start);
         }
-        $start = $line[0];
+        $start = $codepoint;
         $curr = $line[2];
     }
     my $upper = $line[12];
@@ -40,32 +62,44 @@ while (<$fh>) {
     my $title = $line[14];
     chomp $title; # FML
     if ($upper || $lower || $title) {
-        # Cases
-        if ($upper) {
-            $upper = "0x$upper";
-        } else {
-            $upper = '-1';
-        }
-        if ($lower) {
-            $lower = "0x$lower";
-        } else {
-            $lower = '-1';
+        my $record = join ', ', map { $_ ? hex($_) - $codepoint : 0 } $lower, $upper, $title;
+        unless (exists $case_index{$record}) {
+            $case_index{$record} = scalar @case_records;
+            push @case_records, $record;
         }
-        if ($title) {
-            $title = "0x$title";
-        } else {
-            $title = '-1';
-        }
-        my %value = (
-            'codepoint' => "0x$line[0]",
-            'upper' => $upper,
-            'lower' => $lower,
-            'title' => $title
-            );
-        push @char_data, \%value;
+        $case_data[$codepoint] = $case_index{$record};
     }
 }
 close($fh);
+substr($class_data, $start, CODE_POINTS - $start) = chr($class_index{$curr}) x (CODE_POINTS - $start);
+
+die "Too many case records" if @case_records > 256;
+
+# Splits per-code-point values into a two-level table, returning the
+# first level and the distinct blocks of the second.
+sub two_level {
+    my ($value) = @_;
+    my @first;
+    my @second;
+    my %seen;
+    for (my $block = 0; $block < CODE_POINTS; $block += BLOCK_SIZE) {
+        my $contents = join ', ', map { $value->($_) } $block .. $block + BLOCK_SIZE - 1;
+        unless (exists $seen{$contents}) {
+            $seen{$contents} = scalar @second;
+            push @second, $contents;
+        }
+        push @first, $seen{$contents};
+    }
+    return (\@first, \@second);
+}
+
+# Joins numbers sixteen to a line.
+sub rows {
+    my @values = @_;
+    my @rows;
+    push @rows, join ', ', splice(@values, 0, 16) while @values;
+    return @rows;
+}
 
 if ($ARGV[0] eq 'header') {
 
@@ -103,104 +137,76 @@ END_CC
 
 } elsif ($ARGV[0] eq 'source') {
 
+    my ($class_first, $class_second) = two_level(sub { ord substr($class_data, $_[0], 1) });
+    my ($case_first, $case_second) = two_level(sub { $case_data[$_[0]] });
+
     local $" = ",\n    ";
-    my @block_data = map { "{ 0x$_->{start}, 0x$_->{end}, UNICLS_@{[uc $_->{class}]} }" } @data;
-    my @char_code = map { "{ $_->{codepoint}, $_->{lower}, $_->{upper}, $_->{title} }" } @char_data;
+    my @class_stage1 = rows(@$class_first);
+    my @case_stage1 = rows(@$case_first);
+    my @case_code = map { "{ $_ }" } @case_records;
 
     print <<"END_CC";
 
 // This file is generated by unicode_data.pl. Do not modify by hand.
 
 #include "pl_Unidata.h"
-#define NULL 0
 
-struct block_data_t {
-    long start;
-    long end;
-    enum uni_class_t class;
+#define BLOCK_SHIFT @{[BLOCK_SHIFT]}
+#define BLOCK_MASK @{[BLOCK_SIZE - 1]}
+#define MAX_CODEPOINT @{[CODE_POINTS - 1]}
+
+struct case_data_t {
+    int lower;
+    int upper;
+    int title;
 };
 
-struct char_data_t {
-    long codepoint;
-    long lower;
-    long upper;
-    long title;
+static const unsigned short class_stage1[] = {
+    @class_stage1
 };
 
-static struct block_data_t all_block_data[] = {
-    @block_data
+static const unsigned char class_stage2[] = {
+    @$class_second
 };
-static const int BLOCK_COUNT = @{[scalar @block_data]};
 
-static struct char_data_t all_char_data[] = {
-    @char_code
+static const unsigned short case_stage1[] = {
+    @case_stage1
 };
-static const int CHAR_COUNT = @{[scalar @char_code]};
-
-struct block_data_t* get_block(long codepoint) {
-    int begin = 0;
-    int end = BLOCK_COUNT;
-    while (1) {
-        int pivot = (begin + end) / 2;
-        if (codepoint < all_block_data[pivot].start) {
-            end = pivot;
-        } else if (codepoint >= all_block_data[pivot].end) {
-            begin = pivot + 1;
-        } else {
-            return &all_block_data[pivot];
-        }
-    }
-}
 
-struct char_data_t* get_char(long codepoint) {
-    int begin = 0;
-    int end = CHAR_COUNT;
-    while (1) {
-        int pivot = (begin + end) / 2;
-        if (codepoint < all_char_data[pivot].codepoint) {
-            end = pivot;
-        } else if (codepoint > all_char_data[pivot].codepoint) {
-            begin = pivot + 1;
-        } else {
-            return &all_char_data[pivot];
-        }
-        if (begin >= end)
-            return NULL;
-    }
+static const unsigned char case_stage2[] = {
+    @$case_second
+};
+
+static const struct case_data_t all_case_data[] = {
+    @case_code
+};
+
+static const struct case_data_t* get_case(int codepoint) {
+    int block;
+    if ((codepoint < 0) || (codepoint > MAX_CODEPOINT))
+        return &all_case_data[0];
+    block = case_stage1[codepoint >> BLOCK_SHIFT];
+    return &all_case_data[case_stage2[(block << BLOCK_SHIFT) | (codepoint & BLOCK_MASK)]];
 }
 
 enum uni_class_t get_class(int codepoint) {
-    return get_block(codepoint)->class;
+    int block;
+    if ((codepoint < 0) || (codepoint > MAX_CODEPOINT))
+        return UNICLS_CN;
+    block = class_stage1[codepoint >> BLOCK_SHIFT];
+    return (enum uni_class_t)class_stage2[(block << BLOCK_SHIFT) | (codepoint & BLOCK_MASK)];
 }
 
 int to_upper(int codepoint) {
-    struct char_data_t* data = get_char(codepoint);
-    if (data == NULL)
-        return codepoint;
-    else if (data->upper == -1)
-        return codepoint;
-    else
-        return (int)data->upper;
+    return codepoint + get_case(codepoint)->upper;
 }
 
 int to_lower(int codepoint) {
-    struct char_data_t* data = get_char(codepoint);
-    if (data == NULL)
-        return codepoint;
-    else if (data->lower == -1)
-        return codepoint;
-    else
-        return (int)data->lower;
+    return codepoint + get_case(codepoint)->lower;
 }
 
 int to_title(int codepoint) {
-    struct char_data_t* data = get_char(codepoint);
-    if (data == NULL)
-        return codepoint;
-    else if (data->title == -1)
-        return codepoint;
-    else
-        return (int)data->title;
+    return codepoint + get_case(codepoint)->title;
 }
 
 END_CC
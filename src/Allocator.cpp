@@ -38,6 +38,7 @@ ObjectPtr Allocator::allocate() {
                     entry.in_use = true;
                     entry.index = index;
                     entry.ref_count = 0;
+                    entry.profile_site = 0;
                     entry.object = Object();
                     return ObjectPtr(&entry.object);
                 }
@@ -55,6 +56,32 @@ void Allocator::free(Object* obj) {
     ObjectEntry* entry = reinterpret_cast<ObjectEntry*>(obj);
     CountedArray& carray = vec[entry->index];
     entry->in_use = false;
+    Utf8IndexCache::get().forget(obj);
     entry->object = Object(); // TODO This is probably slowing the GC down; can we make it more efficient?
     carray.used--;
 }
+
+unsigned int Allocator::profileSite(Object* obj) noexcept {
+    return reinterpret_cast<ObjectEntry*>(obj)->profile_site;
+}
+
+void Allocator::setProfileSite(Object* obj, unsigned int site) noexcept {
+    reinterpret_cast<ObjectEntry*>(obj)->profile_site = site;
+}
+
+void Allocator::clearProfileSites() noexcept {
+    for (CountedArray& carray : vec) {
+        for (ObjectEntry& entry : carray.array)
+            entry.profile_site = 0;
+    }
+}
+
+AllocatorStats Allocator::stats() const {
+    AllocatorStats result { vec.size(), vec.size() * BUCKET_SIZE, 0, 0 };
+    for (const CountedArray& carray : vec) {
+        result.used += carray.used;
+        if (carray.used > 0)
+            result.holes += BUCKET_SIZE - carray.used;
+    }
+    return result;
+}
@@ -30,6 +30,9 @@ struct ObjectEntry {
     unsigned int index;
     /// The reference counter for the specific entry.
     unsigned int ref_count;
+    /// The allocation profiler's site index for the object, plus one,
+    /// or zero if the object is not being tracked by the profiler.
+    unsigned int profile_site;
 };
 
 /// \brief A CountedArray keeps a count of the number of elements
@@ -51,6 +54,20 @@ struct CountedArray {
     CountedArray();
 };
 
+/// \brief A snapshot of the allocator's bucket usage.
+struct AllocatorStats {
+    /// The number of buckets.
+    size_t buckets;
+    /// The total number of object slots across all buckets.
+    size_t capacity;
+    /// The number of slots which are in use.
+    size_t used;
+    /// The number of free slots in buckets which also contain objects
+    /// in use. Buckets are never released, so these slots are only
+    /// useful for future allocations.
+    size_t holes;
+};
+
 /// \brief A singleton object managing allocation and deallocation of
 /// Latitude objects.
 ///
@@ -94,6 +111,28 @@ public:
     /// GC::free(Object*) should be used.
     void free(Object* ptr);
 
+    /// Computes the current bucket usage of the allocator. This
+    /// requires a pass over the buckets, not over individual objects.
+    ///
+    /// \return the usage statistics
+    AllocatorStats stats() const;
+
+    /// Returns the allocation profiler's tag for the object, which is
+    /// zero for newly allocated objects.
+    ///
+    /// \param obj an object created by this allocator
+    /// \return the tag
+    static unsigned int profileSite(Object* obj) noexcept;
+
+    /// Sets the allocation profiler's tag for the object.
+    ///
+    /// \param obj an object created by this allocator
+    /// \param site the new tag
+    static void setProfileSite(Object* obj, unsigned int site) noexcept;
+
+    /// Resets the allocation profiler's tag on every object to zero.
+    void clearProfileSites() noexcept;
+
 };
 
 #endif // ALLOCATOR_HPP
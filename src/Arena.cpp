@@ -0,0 +1,52 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+
+#include "Arena.hpp"
+#include <cassert>
+#include <functional>
+
+constexpr size_t FIRST_BLOCK_SIZE = 16384;
+
+Arena::Arena() : blocks(), current(0), offset(0) {}
+
+void* Arena::allocate(size_t size, size_t align) {
+    assert((align & (align - 1)) == 0);
+    while (current < blocks.size()) {
+        Block& block = blocks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        size_t start = ((base + offset + align - 1) & ~(uintptr_t)(align - 1)) - base;
+        if (start + size <= block.size) {
+            offset = start + size;
+            return block.data.get() + start;
+        }
+        // Move on to the next block, if there is one left over from
+        // before the last release
+        ++current;
+        offset = 0;
+    }
+    // Each new block is twice the size of the last, and always large
+    // enough for the request
+    size_t blockSize = blocks.empty() ? FIRST_BLOCK_SIZE : blocks.back().size * 2;
+    while (blockSize < size + align)
+        blockSize *= 2;
+    blocks.push_back({ std::unique_ptr<char[]>(new char[blockSize]), blockSize });
+    current = blocks.size() - 1;
+    offset = 0;
+    return allocate(size, align);
+}
+
+bool Arena::owns(const void* ptr) const noexcept {
+    std::less_equal<const void*> le;
+    std::less<const void*> lt;
+    for (const Block& block : blocks) {
+        if (le(block.data.get(), ptr) && lt(ptr, block.data.get() + block.size))
+            return true;
+    }
+    return false;
+}
+
+void Arena::release() noexcept {
+    current = 0;
+    offset = 0;
+}
@@ -0,0 +1,66 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// \file
+///
+/// \brief The Arena class, a region allocator for short-lived data.
+
+/// An Arena is a region allocator. Memory is handed out by bumping a
+/// pointer through a list of large blocks and is never freed
+/// individually; instead, the whole arena is reclaimed at once with
+/// Arena::release. The blocks themselves are kept after a release, so
+/// an arena which is used repeatedly for similarly-sized work stops
+/// allocating from the system entirely.
+///
+/// An arena does not run destructors. Objects with nontrivial
+/// destructors must be destroyed by their owners before the arena is
+/// released.
+class Arena {
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+    std::vector<Block> blocks;
+    size_t current;
+    size_t offset;
+public:
+
+    /// Constructs an empty arena. No memory is allocated until the
+    /// first call to #allocate.
+    Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// Allocates a region of memory within the arena. The memory is
+    /// uninitialized and remains valid until the next call to
+    /// #release or until the arena is destroyed.
+    ///
+    /// \param size the number of bytes
+    /// \param align the required alignment, which must be a power of two
+    /// \return a pointer to the region
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    /// Returns whether the pointer refers to memory within one of the
+    /// arena's blocks.
+    ///
+    /// \param ptr a pointer
+    /// \return whether the arena owns the pointer
+    bool owns(const void* ptr) const noexcept;
+
+    /// Reclaims every allocation made in the arena at once. Pointers
+    /// previously returned from #allocate are invalidated.
+    void release() noexcept;
+
+};
+
+#endif // ARENA_HPP
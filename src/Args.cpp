@@ -37,6 +37,11 @@ CmdArgs parseArgs(int& argc, char**& argv) {
 
     result.run = RunMode::RUNNER;
     result.output = OutputMode::NONE;
+    result.level = optimize::Level::FULL;
+    result.instrProfile = "";
+    result.profile = "";
+    result.allocProfile = "";
+    result.gcLog = "";
 
     for (int i = 1; i < len; i++) {
         if (std::strcmp(argv[i], "--version") == 0) {
@@ -54,6 +59,34 @@ CmdArgs parseArgs(int& argc, char**& argv) {
             result.run = RunMode::COMPILE;
             result.output = OutputMode::NONE;
             argc--;
+        } else if (std::strcmp(argv[i], "-O0") == 0) {
+            // Disable bytecode optimization
+            result.level = optimize::Level::NONE;
+            argc--;
+        } else if (std::strcmp(argv[i], "-O1") == 0) {
+            // Basic bytecode optimization
+            result.level = optimize::Level::BASIC;
+            argc--;
+        } else if (std::strcmp(argv[i], "-O2") == 0) {
+            // Full bytecode optimization
+            result.level = optimize::Level::FULL;
+            argc--;
+        } else if (std::strncmp(argv[i], "--instr-profile=", 16) == 0) {
+            // Enable the instruction profiler
+            result.instrProfile = argv[i] + 16;
+            argc--;
+        } else if (std::strncmp(argv[i], "--profile=", 10) == 0) {
+            // Enable the sampling profiler
+            result.profile = argv[i] + 10;
+            argc--;
+        } else if (std::strncmp(argv[i], "--alloc-profile=", 16) == 0) {
+            // Enable the allocation profiler
+            result.allocProfile = argv[i] + 16;
+            argc--;
+        } else if (std::strncmp(argv[i], "--gc-log=", 9) == 0) {
+            // Log garbage collection statistics
+            result.gcLog = argv[i] + 9;
+            argc--;
         } else {
             // Unrecognized command, so keep it
             argv[j++] = argv[i];
@@ -71,6 +104,15 @@ void outputHelp() {
     std::cout << "  --help     Show this message and exit" << std::endl;
     std::cout << "  --version  Print the current version and exit" << std::endl;
     std::cout << "  --compile  Compile the standard library and given file, then exit" << std::endl;
+    std::cout << "  -O<n>      Set the bytecode optimization level (0, 1, or 2; default 2)" << std::endl;
+    std::cout << "  --profile=<file>" << std::endl;
+    std::cout << "             Sample the call stack, writing folded stacks to <file>" << std::endl;
+    std::cout << "  --gc-log=<file>" << std::endl;
+    std::cout << "             Append statistics for each garbage collection to <file> as JSON" << std::endl;
+    std::cout << "  --alloc-profile=<file>" << std::endl;
+    std::cout << "             Attribute allocations to source lines, writing results to <file>" << std::endl;
+    std::cout << "  --instr-profile=<file>" << std::endl;
+    std::cout << "             Profile each instruction executed, writing results to <file>" << std::endl;
     std::cout << "If a filename is provided, that file will be executed," << std::endl;
     std::cout << "with the given command line arguments. If no additional" << std::endl;
     std::cout << "arguments are supplied, a REPL will be started." << std::endl;
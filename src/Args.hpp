@@ -4,6 +4,7 @@
 #ifndef ARGS_HPP
 #define ARGS_HPP
 
+#include "Optimizer.hpp"
 #include <string>
 
 /// \file
@@ -53,6 +54,19 @@ enum class OutputMode {
 struct CmdArgs {
     RunMode run;
     OutputMode output;
+    optimize::Level level;
+    /// The file to which instruction profile data should be written,
+    /// or the empty string if instruction profiling is disabled.
+    std::string instrProfile;
+    /// The file to which sampling profile data should be written, or
+    /// the empty string if sampling profiling is disabled.
+    std::string profile;
+    /// The file to which allocation profile data should be written,
+    /// or the empty string if allocation profiling is disabled.
+    std::string allocProfile;
+    /// The file to which garbage collection statistics should be
+    /// logged, or the empty string if logging is disabled.
+    std::string gcLog;
 };
 
 /// A Latitude release can be an alpha release, a beta release, or a
@@ -176,6 +176,15 @@ std::vector<AsmType> argPush(Instr instr) {
     case Instr::MSWAP:
         _V::ArgPush<typename _V::Necessary<Instr::MSWAP>::type>::push(vec);
         break;
+    case Instr::ARGLD:
+        _V::ArgPush<typename _V::Necessary<Instr::ARGLD>::type>::push(vec);
+        break;
+    case Instr::RTRVR:
+        _V::ArgPush<typename _V::Necessary<Instr::RTRVR>::type>::push(vec);
+        break;
+    case Instr::CALLR:
+        _V::ArgPush<typename _V::Necessary<Instr::CALLR>::type>::push(vec);
+        break;
     }
     return vec;
 }
@@ -186,6 +186,12 @@ namespace _V {
     struct Necessary<Instr::GOTO> { typedef std::tuple<> type; };
     template <>
     struct Necessary<Instr::MSWAP> { typedef std::tuple<> type; };
+    template <>
+    struct Necessary<Instr::ARGLD> { typedef std::tuple<VLong> type; };
+    template <>
+    struct Necessary<Instr::RTRVR> { typedef std::tuple<VLong> type; };
+    template <>
+    struct Necessary<Instr::CALLR> { typedef std::tuple<VLong> type; };
 
     template <typename T>
     struct ArgToEnum;
@@ -8,58 +8,12 @@
 #include "Assembler.hpp"
 #include "Parents.hpp"
 #include "GC.hpp"
+#include "Profiler.hpp"
 
 //#define DEBUG_INSTR 1
 
 using namespace std;
 
-#ifdef PROFILE_INSTR
-
-Profiling Profiling::instance;
-
-Profiling& Profiling::get() noexcept {
-    return instance;
-}
-
-void Profiling::_begin(unsigned char x) {
-    current = x;
-    tick = std::chrono::high_resolution_clock::now();
-}
-
-void Profiling::_end(unsigned char x) {
-    auto now = std::chrono::high_resolution_clock::now();
-    assert(current == x);
-    times[current] += (now - tick);
-    ++counts[current];
-}
-
-void Profiling::etcBegin() {
-    _begin(0);
-}
-
-void Profiling::etcEnd() {
-    _end(0);
-}
-
-void Profiling::instructionBegin(Instr x) {
-    _begin((unsigned char)x);
-}
-
-void Profiling::instructionEnd(Instr x) {
-    _end((unsigned char)x);
-}
-
-void Profiling::dumpData() {
-    std::cout << "Profile data:" << std::endl;
-    std::cout << "ins\tcount\ttime" << std::endl;
-    for (int ch = 0; ch <= 255; ch++) {
-        auto count = std::chrono::duration_cast<std::chrono::nanoseconds>(times[ch]);
-        std::cout << ch << "\t" << counts[ch] << "\t" << count.count() << " ns" << std::endl;
-    }
-}
-
-#endif
-
 Thunk::Thunk(Method code, ObjectPtr lex, ObjectPtr dyn)
     : code(code), lex(lex), dyn(dyn) {}
 
@@ -148,6 +102,158 @@ void popTrace(IntState& state) {
     state.file = std::get<1>(curr);
 }
 
+/// Performs the `call` instruction, calling %%ptr on %%slf with the
+/// given number of arguments from %%arg.
+///
+/// \param vm the virtual machine state
+/// \param args the argument count
+static void performCall(VMState& vm, long args) {
+    // (1) Perform a hard check for `closure`
+    auto stmt = boost::get<Method>(&vm.trans.ptr->prim());
+    ObjectPtr closure = (*vm.trans.ptr)[ Symbols::get()["closure"] ];
+#if DEBUG_INSTR > 2
+    cout << "* Method Properties " <<
+        (closure != nullptr) << " " <<
+        (stmt ? stmt->index().index : -1) << " " <<
+        (stmt ? stmt->translationUnit() : nullptr) << endl;
+#endif
+    if ((closure != nullptr) && stmt) {
+        // It's a method; get ready to call it
+        // (2) Try to clone the top of %dyn
+        if (!vm.state.dyn.empty())
+            vm.state.dyn.push( clone(vm.state.dyn.top()) );
+        else
+            vm.trans.err0 = true;
+        // (3) Push a clone of the closure onto %lex
+        auto lex = vm.state.lex.top();
+        vm.state.lex.push( clone(closure) );
+        // (4) Bind all the local variables
+        vm.state.lex.top()->put(Symbols::get()["self"], vm.trans.slf);
+        vm.state.lex.top()->put(Symbols::get()["again"], vm.trans.ptr);
+        vm.state.lex.top()->put(Symbols::get()["caller"], lex);
+        vm.state.lex.top()->protectAll(Protection::PROTECT_ASSIGN | Protection::PROTECT_DELETE,
+                                    Symbols::get()["self"], Symbols::get()["again"]);
+        // (5) Push the trace information
+        pushTrace(vm.state);
+        // (6) Bind all of the arguments
+        if (!vm.state.dyn.empty()) {
+            int index = args;
+            for (long n = 0; n < args; n++) {
+                ObjectPtr arg = vm.state.arg.top();
+                vm.state.arg.pop();
+                vm.state.dyn.top()->put(Symbols::get()[ "$" + to_string(index) ], arg);
+                index--;
+            }
+        }
+        // (7) Push %cont onto %stack
+        vm.state.stack = pushNode(vm.state.stack, vm.state.cont);
+        vm.state.trns.push(stmt->translationUnit());
+        // (8) Make a new %cont
+        if (stmt) {
+#if DEBUG_INSTR > 3
+            cout << "* (cont) " << stmt->size() << endl;
+            if (stmt->size() == 0) {
+                // What are we looking at...?
+                cout << "* * Where ptr has" << endl;
+                for (auto& x : keys(vm.trans.ptr))
+                    cout << "  " << Symbols::get()[x];
+                cout << endl;
+                cout << "* * Directly" << endl;
+                for (auto& x : (vm.trans.ptr)->directKeys())
+                    cout << "  " << Symbols::get()[x];
+                cout << endl;
+                cout << "* * Parents of ptr" << endl;
+                for (auto& x : hierarchy(vm.trans.ptr))
+                    cout << "  " << x;
+                cout << endl;
+                cout << "* * Following the prims of ptr" << endl;
+                for (auto& x : hierarchy(vm.trans.ptr))
+                    cout << "  " << x->prim().which();
+                cout << endl;
+            }
+#endif
+            vm.state.cont = MethodSeek(*stmt);
+        }
+    } else {
+        // It's not a method; just return it
+        for (long n = 0; n < args; n++) {
+            vm.state.arg.pop(); // For consistency, we must pop and discard these anyway
+        }
+        vm.trans.ret = vm.trans.ptr;
+    }
+}
+
+/// Performs the `rtrv` instruction, looking up %%sym on %%slf and
+/// falling back to `missing` or `missed` as necessary.
+///
+/// \param vm the virtual machine state
+static void performRetrieve(VMState& vm) {
+    // Try to find the value itsel
+    ObjectPtr value = objectGet(vm.trans.slf, vm.trans.sym);
+    if (value == nullptr) {
+#if DEBUG_INSTR > 2
+        cout << "* Looking for missing" << endl;
+#if DEBUG_INSTR > 3
+        cout << "* Information:" << endl;
+        cout << "* * Lex: " << vm.state.lex.top() << endl;
+        cout << "* * Dyn: " << vm.state.dyn.top() << endl;
+        cout << "* * Slf: " << vm.trans.slf << endl;
+#endif
+#endif
+        // Now try for missing
+        value = objectGet(vm.trans.slf, Symbols::get()["missing"]);
+#if DEBUG_INSTR > 1
+        if (value == nullptr)
+            cout << "* Found no missing" << endl;
+        else
+            cout << "* Found missing" << endl;
+#endif
+        if (value == nullptr) {
+            ObjectPtr meta = nullptr;
+            // If there is no `missing` either, fall back to the last resort
+            if (!vm.state.lex.empty()) {
+                value = objectGet(vm.state.lex.top(), Symbols::get()["meta"]);
+                meta = value;
+            }
+            if (value != nullptr)
+                value = objectGet(value, Symbols::get()["missed"]);
+#if DEBUG_INSTR > 1
+            if (value == nullptr)
+                cout << "* Found no missed" << endl;
+            else
+                cout << "* Found missed" << endl;
+#endif
+            if (value == nullptr) {
+                // Abandon ship!
+                vm.state.stack = pushNode(vm.state.stack, vm.state.cont);
+                vm.state.cont = MethodSeek(Method(vm.reader.gtu, { Table::GTU_TERMINATE }));
+            } else {
+                vm.trans.slf = meta;
+                vm.trans.ptr = value;
+                vm.state.stack = pushNode(vm.state.stack, vm.state.cont);
+                vm.state.cont = MethodSeek(Method(vm.reader.gtu, { Table::GTU_CALL_ZERO }));
+            }
+        } else {
+            //vm.trans.sym = backup;
+            vm.trans.ret = value;
+            //vm.trans.slf = vm.trans.slf;
+            vm.state.stack = pushNode(vm.state.stack, vm.state.cont);
+            vm.state.cont = MethodSeek(Method(vm.reader.gtu, { Table::GTU_MISSING }));
+        }
+    } else {
+#if DEBUG_INSTR > 1
+        cout << "* Found " << value << endl;
+#if DEBUG_INSTR > 2
+        auto stmt = boost::get<Method>(&value->prim());
+        cout << "* Method Properties " <<
+            (stmt ? stmt->index().index : -1) << " " <<
+            (stmt ? stmt->translationUnit() : nullptr) << endl;
+#endif
+#endif
+        vm.trans.ret = value;
+    }
+}
+
 void executeInstr(Instr instr, VMState& vm) {
     switch (instr) {
     case Instr::MOV: {
@@ -405,79 +511,7 @@ void executeInstr(Instr instr, VMState& vm) {
         cout << "* Method Properties " << vm.trans.ptr << endl;
 #endif
 #endif
-        // (1) Perform a hard check for `closure`
-        auto stmt = boost::get<Method>(&vm.trans.ptr->prim());
-        ObjectPtr closure = (*vm.trans.ptr)[ Symbols::get()["closure"] ];
-#if DEBUG_INSTR > 2
-        cout << "* Method Properties " <<
-            (closure != nullptr) << " " <<
-            (stmt ? stmt->index().index : -1) << " " <<
-            (stmt ? stmt->translationUnit() : nullptr) << endl;
-#endif
-        if ((closure != nullptr) && stmt) {
-            // It's a method; get ready to call it
-            // (2) Try to clone the top of %dyn
-            if (!vm.state.dyn.empty())
-                vm.state.dyn.push( clone(vm.state.dyn.top()) );
-            else
-                vm.trans.err0 = true;
-            // (3) Push a clone of the closure onto %lex
-            auto lex = vm.state.lex.top();
-            vm.state.lex.push( clone(closure) );
-            // (4) Bind all the local variables
-            vm.state.lex.top()->put(Symbols::get()["self"], vm.trans.slf);
-            vm.state.lex.top()->put(Symbols::get()["again"], vm.trans.ptr);
-            vm.state.lex.top()->put(Symbols::get()["caller"], lex);
-            vm.state.lex.top()->protectAll(Protection::PROTECT_ASSIGN | Protection::PROTECT_DELETE,
-                                        Symbols::get()["self"], Symbols::get()["again"]);
-            // (5) Push the trace information
-            pushTrace(vm.state);
-            // (6) Bind all of the arguments
-            if (!vm.state.dyn.empty()) {
-                int index = args;
-                for (long n = 0; n < args; n++) {
-                    ObjectPtr arg = vm.state.arg.top();
-                    vm.state.arg.pop();
-                    vm.state.dyn.top()->put(Symbols::get()[ "$" + to_string(index) ], arg);
-                    index--;
-                }
-            }
-            // (7) Push %cont onto %stack
-            vm.state.stack = pushNode(vm.state.stack, vm.state.cont);
-            vm.state.trns.push(stmt->translationUnit());
-            // (8) Make a new %cont
-            if (stmt) {
-#if DEBUG_INSTR > 3
-                cout << "* (cont) " << stmt->size() << endl;
-                if (stmt->size() == 0) {
-                    // What are we looking at...?
-                    cout << "* * Where ptr has" << endl;
-                    for (auto& x : keys(vm.trans.ptr))
-                        cout << "  " << Symbols::get()[x];
-                    cout << endl;
-                    cout << "* * Directly" << endl;
-                    for (auto& x : (vm.trans.ptr)->directKeys())
-                        cout << "  " << Symbols::get()[x];
-                    cout << endl;
-                    cout << "* * Parents of ptr" << endl;
-                    for (auto& x : hierarchy(vm.trans.ptr))
-                        cout << "  " << x;
-                    cout << endl;
-                    cout << "* * Following the prims of ptr" << endl;
-                    for (auto& x : hierarchy(vm.trans.ptr))
-                        cout << "  " << x->prim().which();
-                    cout << endl;
-                }
-#endif
-                vm.state.cont = MethodSeek(*stmt);
-            }
-        } else {
-            // It's not a method; just return it
-            for (long n = 0; n < args; n++) {
-                vm.state.arg.pop(); // For consistency, we must pop and discard these anyway
-            }
-            vm.trans.ret = vm.trans.ptr;
-        }
+        performCall(vm, args);
     }
         break;
     case Instr::XCALL: {
@@ -573,70 +607,7 @@ void executeInstr(Instr instr, VMState& vm) {
 #if DEBUG_INSTR > 0
         cout << "RTRV (" << Symbols::get()[vm.trans.sym] << ")" << endl;
 #endif
-        // Try to find the value itsel
-        ObjectPtr value = objectGet(vm.trans.slf, vm.trans.sym);
-        if (value == nullptr) {
-#if DEBUG_INSTR > 2
-            cout << "* Looking for missing" << endl;
-#if DEBUG_INSTR > 3
-            cout << "* Information:" << endl;
-            cout << "* * Lex: " << vm.state.lex.top() << endl;
-            cout << "* * Dyn: " << vm.state.dyn.top() << endl;
-            cout << "* * Slf: " << vm.trans.slf << endl;
-#endif
-#endif
-            // Now try for missing
-            value = objectGet(vm.trans.slf, Symbols::get()["missing"]);
-#if DEBUG_INSTR > 1
-            if (value == nullptr)
-                cout << "* Found no missing" << endl;
-            else
-                cout << "* Found missing" << endl;
-#endif
-            if (value == nullptr) {
-                ObjectPtr meta = nullptr;
-                // If there is no `missing` either, fall back to the last resort
-                if (!vm.state.lex.empty()) {
-                    value = objectGet(vm.state.lex.top(), Symbols::get()["meta"]);
-                    meta = value;
-                }
-                if (value != nullptr)
-                    value = objectGet(value, Symbols::get()["missed"]);
-#if DEBUG_INSTR > 1
-                if (value == nullptr)
-                    cout << "* Found no missed" << endl;
-                else
-                    cout << "* Found missed" << endl;
-#endif
-                if (value == nullptr) {
-                    // Abandon ship!
-                    vm.state.stack = pushNode(vm.state.stack, vm.state.cont);
-                    vm.state.cont = MethodSeek(Method(vm.reader.gtu, { Table::GTU_TERMINATE }));
-                } else {
-                    vm.trans.slf = meta;
-                    vm.trans.ptr = value;
-                    vm.state.stack = pushNode(vm.state.stack, vm.state.cont);
-                    vm.state.cont = MethodSeek(Method(vm.reader.gtu, { Table::GTU_CALL_ZERO }));
-                }
-            } else {
-                //vm.trans.sym = backup;
-                vm.trans.ret = value;
-                //vm.trans.slf = vm.trans.slf;
-                vm.state.stack = pushNode(vm.state.stack, vm.state.cont);
-                vm.state.cont = MethodSeek(Method(vm.reader.gtu, { Table::GTU_MISSING }));
-            }
-        } else {
-#if DEBUG_INSTR > 1
-            cout << "* Found " << value << endl;
-#if DEBUG_INSTR > 2
-            auto stmt = boost::get<Method>(&value->prim());
-            cout << "* Method Properties " <<
-                (stmt ? stmt->index().index : -1) << " " <<
-                (stmt ? stmt->translationUnit() : nullptr) << endl;
-#endif
-#endif
-            vm.trans.ret = value;
-        }
+        performRetrieve(vm);
     }
         break;
     case Instr::RTRVD: {
@@ -1273,13 +1244,13 @@ void executeInstr(Instr instr, VMState& vm) {
         cout << "ARR " << val << endl;
 #endif
         ObjectPtr arr = clone(vm.reader.lit.at(Lit::ARRAY));
-        int j = 2 * (int)val - 1;
-        for (long i = 0; i < val; i++, j -= 2) {
-            arr->put(Symbols::natural(j), vm.state.arg.top());
+        ArrayStore store;
+        std::deque<ObjectPtr>& elements = store.elements();
+        for (long i = 0; i < val; i++) {
+            elements.push_front(vm.state.arg.top());
             vm.state.arg.pop();
         }
-        arr->put(Symbols::get()["lowerBound"], garnishObject(vm.reader, 0));
-        arr->put(Symbols::get()["upperBound"], garnishObject(vm.reader, val));
+        arr->prim() = std::move(store);
         vm.trans.ret = arr;
     }
         break;
@@ -1288,25 +1259,18 @@ void executeInstr(Instr instr, VMState& vm) {
 #if DEBUG_INSTR > 0
         cout << "DICT " << val << endl;
 #endif
-        ObjectPtr dict = vm.reader.lit.at(Lit::DICT);
-        ObjectPtr impl0 = (*dict)[Symbols::get()["&impl"]];
-        ObjectPtr impl = clone(impl0);
-        (*impl) = (*impl0);
-        dict = clone(dict);
-        dict->put(Symbols::get()["&impl"], impl);
-        for (long i = 0; i < val; i++) {
-            ObjectPtr value = vm.state.arg.top();
-            vm.state.arg.pop();
-            ObjectPtr key = vm.state.arg.top();
+        ObjectPtr dict = clone(vm.reader.lit.at(Lit::DICT));
+        // The arguments are popped in reverse order, but the entries
+        // should be added in the order written.
+        std::vector<ObjectPtr> args(2 * val);
+        for (long i = 2 * val - 1; i >= 0; i--) {
+            args[i] = vm.state.arg.top();
             vm.state.arg.pop();
-            auto key0 = boost::get<Symbolic>(&key->prim());
-            if (key0) {
-                impl->put(*key0, value);
-            } else {
-                throwError(vm, "TypeError", "Symbol expected");
-                return;
-            }
         }
+        DictStore store;
+        for (long i = 0; i < val; i++)
+            store.put(args[2 * i], args[2 * i + 1]);
+        dict->prim() = std::move(store);
         vm.trans.ret = dict;
     }
         break;
@@ -1361,6 +1325,45 @@ void executeInstr(Instr instr, VMState& vm) {
         swap(vm.trans.mthd, vm.trans.mthdz);
     }
         break;
+    case Instr::ARGLD: {
+        long val = vm.state.cont.readLong(0);
+#if DEBUG_INSTR > 0
+        cout << "ARGLD " << val << " (" << Symbols::get()[Symbolic{val}] << ")" << endl;
+#endif
+        if (vm.state.dyn.empty())
+            vm.trans.err0 = true;
+        else
+            vm.trans.slf = vm.state.dyn.top();
+        vm.trans.sym = { val };
+        performRetrieve(vm);
+    }
+        break;
+    case Instr::RTRVR: {
+        long val = vm.state.cont.readLong(0);
+#if DEBUG_INSTR > 0
+        cout << "RTRVR " << val << " (" << Symbols::get()[Symbolic{val}] << ")" << endl;
+#endif
+        vm.trans.sym = { val };
+        vm.trans.slf = vm.trans.ret;
+        performRetrieve(vm);
+    }
+        break;
+    case Instr::CALLR: {
+        long args = vm.state.cont.readLong(0);
+#if DEBUG_INSTR > 0
+        cout << "CALLR " << args << " (" << Symbols::get()[vm.trans.sym] << ")" << endl;
+#endif
+        vm.trans.ptr = vm.trans.ret;
+        if (!vm.state.sto.empty()) {
+            vm.trans.slf = vm.state.sto.top();
+            vm.state.sto.pop();
+        } else {
+            vm.trans.slf = nullptr;
+            vm.trans.err0 = true;
+        }
+        performCall(vm, args);
+    }
+        break;
     }
 }
 
@@ -1372,14 +1375,8 @@ void doOneStep(VMState& vm) {
         cout << "<><><>" << endl;
 #endif
         if (vm.state.stack) {
-#ifdef PROFILE_INSTR
-            Profiling::get().etcBegin();
-#endif
             vm.state.cont = vm.state.stack->get();
             vm.state.stack = popNode(vm.state.stack);
-#ifdef PROFILE_INSTR
-            Profiling::get().etcEnd();
-#endif
             doOneStep(vm);
         }
     } else {
@@ -1388,13 +1385,16 @@ void doOneStep(VMState& vm) {
 #if DEBUG_INSTR > 1
         cout << "<" << (long)instr << ">" << endl;
 #endif
-#ifdef PROFILE_INSTR
-        Profiling::get().instructionBegin(instr);
-#endif
-        executeInstr(instr, vm);
-#ifdef PROFILE_INSTR
-        Profiling::get().instructionEnd(instr);
-#endif
+        if (SamplingProfiler::pending)
+            SamplingProfiler::get().sample(vm);
+        InstrProfiler& profiler = InstrProfiler::get();
+        if (profiler.isEnabled()) {
+            profiler.instructionBegin(vm, instr);
+            executeInstr(instr, vm);
+            profiler.instructionEnd();
+        } else {
+            executeInstr(instr, vm);
+        }
         GC::get().tick(vm);
     }
 }
@@ -41,6 +41,19 @@ struct DebugPrimVisitor : boost::static_visitor<std::string> {
         return "StatePtr";
     }
 
+    std::string operator()(const ArrayStore& store) const {
+        return "ArrayStore(" + std::to_string(store.size()) + ")";
+    }
+    std::string operator()(const DictStore& store) const {
+        return "DictStore(" + std::to_string(store.size()) + ")";
+    }
+    std::string operator()(const ByteBuffer& buffer) const {
+        return "ByteBuffer(" + std::to_string(buffer.size()) + ")";
+    }
+    std::string operator()(const RandomGenerator&) const {
+        return "RandomGenerator";
+    }
+
 };
 
 std::string toStringInfo(ObjectPtr obj) {
@@ -3,16 +3,36 @@
 
 #include "GC.hpp"
 #include "Allocator.hpp"
+#include "Profiler.hpp"
 #include <stack>
 #include <set>
 #include <algorithm>
+#include <chrono>
+#include <fstream>
 
 #define GC_PRINT 0
 
 using namespace std;
 
+constexpr int GCStats::HISTOGRAM_SIZE;
+
+long GCStats::pausePercentile(double fraction) const {
+    if (collections == 0)
+        return 0;
+    unsigned long target = (unsigned long)(fraction * collections);
+    if (target >= collections)
+        target = collections - 1;
+    unsigned long seen = 0;
+    for (int i = 0; i < HISTOGRAM_SIZE; i++) {
+        seen += pauseHistogram[i];
+        if (seen > target)
+            return (i == HISTOGRAM_SIZE - 1) ? maxPause : (1L << i);
+    }
+    return maxPause;
+}
+
 GC::GC()
-    : alloc(), count(TOTAL_COUNT), limit(8192L), tracing(false) {}
+    : alloc(), count(TOTAL_COUNT), limit(8192L), tracing(false), stats(), statsFile() {}
 
 GC& GC::get() noexcept {
     return instance;
@@ -24,11 +44,17 @@ ObjectPtr GC::allocate() {
     std::cout << "<<Allocating " << ptr << ">>" << std::endl;
 #endif
     alloc.insert(ptr.get());
+    AllocationProfiler& profiler = AllocationProfiler::get();
+    if (profiler.isEnabled())
+        profiler.recordAllocation(ptr.get());
     return ptr;
 }
 
 void GC::free(Object* obj) {
     if (alloc.erase(obj) > 0) {
+        AllocationProfiler& profiler = AllocationProfiler::get();
+        if (profiler.isEnabled())
+            profiler.recordFree(obj);
         Allocator::get().free(obj);
     }
 }
@@ -150,6 +176,24 @@ void addContinuationToFrontier(const Container& visited, Container& frontier, Tr
     addToFrontier     (visited, frontier, trans.ret .get());
 }
 
+template <typename Container>
+void addArrayToFrontier(const Container& visited, Container& frontier, Object* curr) {
+    if (const ArrayStore* store = boost::get<ArrayStore>(&curr->prim())) {
+        for (const ObjectPtr& value : store->elements())
+            addToFrontier(visited, frontier, value.get());
+    }
+}
+
+template <typename Container>
+void addDictToFrontier(const Container& visited, Container& frontier, Object* curr) {
+    if (const DictStore* store = boost::get<DictStore>(&curr->prim())) {
+        store->forEach([&visited, &frontier](const ObjectPtr& key, const ObjectPtr& value) {
+                addToFrontier(visited, frontier, key.get());
+                addToFrontier(visited, frontier, value.get());
+            });
+    }
+}
+
 template <typename Container>
 void addContinuationToFrontier(const Container& visited, Container& frontier, Object* curr) {
     auto state0 = boost::get<StatePtr>(&curr->prim());
@@ -169,6 +213,8 @@ long GC::garbageCollect(std::vector<Object*> globals) {
     if (tracing) {
         std::cout << "GC: Running.... there are " << getTotal() << " objects in memory." << std::endl;
     }
+    auto start = chrono::steady_clock::now();
+    size_t heapBefore = getTotal();
     std::set<Object*> visited;
     std::set<Object*> frontier;
     for (const auto& elem : globals)
@@ -190,6 +236,8 @@ long GC::garbageCollect(std::vector<Object*> globals) {
         std::cout << "<<Add continuation on locked>>" << std::endl;
 #endif
         addContinuationToFrontier(visited, frontier, curr);
+        addArrayToFrontier(visited, frontier, curr);
+        addDictToFrontier(visited, frontier, curr);
 #if GC_PRINT > 2
         std::cout << "<<Finished with locked>>" << std::endl;
 #endif
@@ -211,10 +259,16 @@ long GC::garbageCollect(std::vector<Object*> globals) {
 #if GC_PRINT > 0
     std::cout << "<<EXIT GC>>" << std::endl;
 #endif
+    auto pause = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+    recordCollection({ stats.collections + 1, (long)pause.count(), visited.size(), result.size(),
+                       heapBefore, getTotal(), limit, Allocator::get().stats() });
     if (tracing) {
         std::cout << "GC: Finished running.... there are now " << getTotal()
                   << " objects." << std::endl;
     }
+    AllocationProfiler& profiler = AllocationProfiler::get();
+    if (profiler.isEnabled())
+        profiler.recordCollection(total);
     return total;
 }
 
@@ -245,6 +299,39 @@ long GC::garbageCollect(VMState& vm) {
     return garbageCollect(globals.value);
 }
 
+void GC::recordCollection(const GCCollectionStats& current) {
+    stats.collections = current.index;
+    stats.totalPause += current.pause;
+    stats.maxPause = std::max(stats.maxPause, current.pause);
+    int bucket = 0;
+    while ((bucket < GCStats::HISTOGRAM_SIZE - 1) && (current.pause >= (1L << bucket)))
+        ++bucket;
+    ++stats.pauseHistogram[bucket];
+    stats.last = current;
+    if (!statsFile.empty()) {
+        ofstream out { statsFile, ios_base::app };
+        out << "{\"collection\":" << current.index
+            << ",\"pause\":" << current.pause
+            << ",\"marked\":" << current.marked
+            << ",\"freed\":" << current.freed
+            << ",\"heapBefore\":" << current.heapBefore
+            << ",\"heapAfter\":" << current.heapAfter
+            << ",\"limit\":" << current.limit
+            << ",\"buckets\":" << current.allocator.buckets
+            << ",\"capacity\":" << current.allocator.capacity
+            << ",\"holes\":" << current.allocator.holes
+            << "}\n";
+    }
+}
+
+const GCStats& GC::getStats() const noexcept {
+    return stats;
+}
+
+void GC::setStatsFile(std::string file) {
+    statsFile = file;
+}
+
 void GC::setTracing(bool val) {
     tracing = val;
 }
@@ -6,14 +6,67 @@
 
 #include "Bytecode.hpp"
 #include "Proto.hpp"
+#include "Allocator.hpp"
 #include <vector>
 #include <array>
 #include <algorithm>
+#include <string>
 
 /// \file
 ///
 /// \brief The garbage collector class
 
+/// \brief Measurements taken during a single garbage collection.
+struct GCCollectionStats {
+    /// The number of collections performed before and including this
+    /// one.
+    unsigned long index;
+    /// The time, in microseconds, for which the program was paused.
+    long pause;
+    /// The number of objects found to be reachable.
+    size_t marked;
+    /// The number of objects freed.
+    size_t freed;
+    /// The number of objects allocated when the collection began.
+    size_t heapBefore;
+    /// The number of objects allocated when the collection finished.
+    size_t heapAfter;
+    /// The object limit in force during the collection.
+    size_t limit;
+    /// The allocator's bucket usage after the collection.
+    AllocatorStats allocator;
+};
+
+/// \brief Cumulative garbage collector measurements.
+struct GCStats {
+
+    /// The number of buckets in the pause time histogram.
+    static constexpr int HISTOGRAM_SIZE = 32;
+
+    /// The total number of collections performed.
+    unsigned long collections;
+    /// The sum of all pause times, in microseconds.
+    long totalPause;
+    /// The longest pause time, in microseconds.
+    long maxPause;
+    /// A histogram of pause times. Bucket 0 counts pauses of less
+    /// than one microsecond, and each bucket `n` thereafter counts
+    /// pauses of at least `2^(n-1)` and less than `2^n` microseconds.
+    /// The final bucket also counts any longer pauses.
+    std::array<unsigned long, HISTOGRAM_SIZE> pauseHistogram;
+    /// The measurements from the most recent collection.
+    GCCollectionStats last;
+
+    /// Estimates a percentile of the pause times from the histogram.
+    /// The result is the upper bound of the histogram bucket
+    /// containing the percentile, so it never underestimates.
+    ///
+    /// \param fraction the percentile, as a number between 0 and 1
+    /// \return an upper bound on the pause time, in microseconds
+    long pausePercentile(double fraction) const;
+
+};
+
 /// A singleton object representing the global garbage collector. All
 /// language `Object` instances should be allocated through this
 /// object so that they can be cleaned up through this object.
@@ -25,7 +78,10 @@ private:
     long count;
     unsigned long limit;
     bool tracing;
+    GCStats stats;
+    std::string statsFile;
     GC();
+    void recordCollection(const GCCollectionStats& current);
 public:
 
     /// Returns the garbage collector singleton instance.
@@ -81,6 +137,19 @@ public:
     /// collector prints a line of text whenever it runs.
     void setTracing(bool);
 
+    /// Returns the cumulative statistics for every collection
+    /// performed so far.
+    ///
+    /// \return the statistics
+    const GCStats& getStats() const noexcept;
+
+    /// Sets the file to which a JSON object describing each
+    /// collection is appended, one per line. The empty string
+    /// disables logging, which is the default.
+    ///
+    /// \param file the file name
+    void setStatsFile(std::string file);
+
     /// Returns the total number of allocated objects registered with
     /// the garbage collector.
     ///
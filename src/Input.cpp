@@ -4,6 +4,7 @@
 
 #include "Input.hpp"
 #include "Platform.hpp"
+#include "Stream.hpp"
 #include <iostream>
 #include <list>
 #include <cassert>
@@ -15,10 +16,11 @@
 
 namespace ReadLine {
 
+    // Input is read through the standard input stream, rather than
+    // from cin, so that it shares a buffer with $stdin.
+
     std::string readBasic() {
-        std::string result;
-        getline(std::cin, result);
-        return result;
+        return inStream()->readLine();
     }
 
 #ifdef USE_POSIX
@@ -46,7 +48,7 @@ namespace ReadLine {
     }
 
     bool _readChar(history_iterator& iter, std::string*& input) {
-        char ch = (char)getchar();
+        char ch = inStream()->in();
         switch (ch) {
         case 0x7f: // Backspace
             if (!input->empty()) {
@@ -56,8 +58,8 @@ namespace ReadLine {
             break;
         case 0x1b: // Escape
             {
-                char next = getchar();
-                char last = getchar();
+                char next = inStream()->in();
+                char last = inStream()->in();
                 if (next == '[') {
                     switch (last) {
                     case 'A': // Up
@@ -84,6 +84,133 @@ void InstructionSet::initialize() {
     props[Instr::XXX] = { isLongRegisterArg };
     props[Instr::GOTO] = { };
     props[Instr::MSWAP] = { };
+    props[Instr::ARGLD] = { isLongRegisterArg };
+    props[Instr::RTRVR] = { isLongRegisterArg };
+    props[Instr::CALLR] = { isLongRegisterArg };
+}
+
+const char* instructionName(Instr instr) {
+    switch (instr) {
+    case Instr::MOV:
+        return "mov";
+    case Instr::PUSH:
+        return "push";
+    case Instr::POP:
+        return "pop";
+    case Instr::GETL:
+        return "getl";
+    case Instr::GETD:
+        return "getd";
+    case Instr::ESWAP:
+        return "eswap";
+    case Instr::ECLR:
+        return "eclr";
+    case Instr::ESET:
+        return "eset";
+    case Instr::SYM:
+        return "sym";
+    case Instr::NUM:
+        return "num";
+    case Instr::INT:
+        return "int";
+    case Instr::FLOAT:
+        return "float";
+    case Instr::NSWAP:
+        return "nswap";
+    case Instr::CALL:
+        return "call";
+    case Instr::XCALL:
+        return "xcall";
+    case Instr::XCALL0:
+        return "xcall0";
+    case Instr::RET:
+        return "ret";
+    case Instr::CLONE:
+        return "clone";
+    case Instr::RTRV:
+        return "rtrv";
+    case Instr::RTRVD:
+        return "rtrvd";
+    case Instr::STR:
+        return "str";
+    case Instr::SSWAP:
+        return "sswap";
+    case Instr::EXPD:
+        return "expd";
+    case Instr::MTHD:
+        return "mthd";
+    case Instr::LOAD:
+        return "load";
+    case Instr::SETF:
+        return "setf";
+    case Instr::PEEK:
+        return "peek";
+    case Instr::SYMN:
+        return "symn";
+    case Instr::CPP:
+        return "cpp";
+    case Instr::BOL:
+        return "bol";
+    case Instr::TEST:
+        return "test";
+    case Instr::BRANCH:
+        return "branch";
+    case Instr::CCALL:
+        return "ccall";
+    case Instr::CGOTO:
+        return "cgoto";
+    case Instr::CRET:
+        return "cret";
+    case Instr::WND:
+        return "wnd";
+    case Instr::UNWND:
+        return "unwnd";
+    case Instr::THROW:
+        return "throw";
+    case Instr::THROQ:
+        return "throq";
+    case Instr::ADDS:
+        return "adds";
+    case Instr::ARITH:
+        return "arith";
+    case Instr::THROA:
+        return "throa";
+    case Instr::LOCFN:
+        return "locfn";
+    case Instr::LOCLN:
+        return "locln";
+    case Instr::LOCRT:
+        return "locrt";
+    case Instr::NRET:
+        return "nret";
+    case Instr::UNTR:
+        return "untr";
+    case Instr::CMPLX:
+        return "cmplx";
+    case Instr::YLD:
+        return "yld";
+    case Instr::YLDC:
+        return "yldc";
+    case Instr::DEL:
+        return "del";
+    case Instr::ARR:
+        return "arr";
+    case Instr::DICT:
+        return "dict";
+    case Instr::XXX:
+        return "xxx";
+    case Instr::GOTO:
+        return "goto";
+    case Instr::MSWAP:
+        return "mswap";
+    case Instr::ARGLD:
+        return "argld";
+    case Instr::RTRVR:
+        return "rtrvr";
+    case Instr::CALLR:
+        return "callr";
+    }
+    return "???";
 }
 
 bool isRegister(const RegisterArg& arg) {
@@ -326,3 +453,7 @@ FunctionIndex MethodSeek::readFunction(int n) {
 InstrSeq& MethodSeek::instructions() {
     return method.instructions();
 }
+
+Method& MethodSeek::getMethod() {
+    return method;
+}
@@ -26,7 +26,8 @@ enum class Instr : unsigned char {
     CPP = 0x1D, BOL = 0x1E, TEST = 0x1F, BRANCH = 0x20, CCALL = 0x21, CGOTO = 0x22, CRET = 0x23,
     WND = 0x24, UNWND = 0x25, THROW = 0x26, THROQ = 0x27, ADDS = 0x28, ARITH = 0x29, THROA = 0x2A,
     LOCFN = 0x2B, LOCLN = 0x2C, LOCRT = 0x2D, NRET = 0x2E, UNTR = 0x2F, CMPLX = 0x30, YLD = 0x31,
-    YLDC = 0x32, DEL = 0x33, ARR = 0x34, DICT = 0x35, XXX = 0x36, GOTO = 0x37, MSWAP = 0x38
+    YLDC = 0x32, DEL = 0x33, ARR = 0x34, DICT = 0x35, XXX = 0x36, GOTO = 0x37, MSWAP = 0x38,
+    ARGLD = 0x39, RTRVR = 0x3A, CALLR = 0x3B
 };
 
 /// The register enumeration, containing numerical values for
@@ -88,6 +89,9 @@ namespace Lit {
     /// \brief The index of the Object object
     constexpr long OBJECT = 13L;
 
+    /// \brief The index of the ByteBuffer object.
+    constexpr long BYTES  = 14L;
+
 }
 
 /// A function index is fundamentally just an integral value. This
@@ -193,6 +197,13 @@ bool isLongRegisterArg(const RegisterArg& arg);
 /// \return whether the argument is a function
 bool isAsmRegisterArg(const RegisterArg& arg);
 
+/// Returns the assembler mnemonic of the instruction, as it appears
+/// in the instruction reference (for instance, `"mov"` or `"symn"`).
+///
+/// \param instr the instruction
+/// \return the mnemonic, or `"???"` if the opcode is invalid
+const char* instructionName(Instr instr);
+
 class AssemblerLineArgs;
 
 /// An AssemblerLine is a single instruction as it is being built
@@ -506,6 +517,11 @@ public:
     /// \return the instruction sequence
     InstrSeq& instructions();
 
+    /// Returns the method being traversed.
+    ///
+    /// \return the method
+    Method& getMethod();
+
 };
 
 #endif // INSTRUCTIONS_HPP
@@ -329,6 +329,29 @@ namespace MagicNumber {
         }
     };
 
+    // Hashes the value as a complex floating-point number. Two numbers
+    // which compare equal have the same value once widened to a
+    // double, so they hash the same regardless of representation.
+    struct HashVisitor : boost::static_visitor<std::size_t> {
+        template <typename U>
+        std::size_t operator()(const U& first) const {
+            return hashParts(static_cast<double>(first), 0.0);
+        }
+        std::size_t operator()(const Number::complex& first) const {
+            return hashParts(first.real(), first.imag());
+        }
+        static std::size_t hashParts(double real, double imag) {
+            // Positive and negative zero are equal, so they must hash
+            // the same.
+            if (real == 0.0)
+                real = 0.0;
+            if (imag == 0.0)
+                imag = 0.0;
+            std::size_t result = std::hash<double>()(real);
+            return result ^ (std::hash<double>()(imag) + 0x9e3779b9 + (result << 6) + (result >> 2));
+        }
+    };
+
     struct LessVisitor : boost::static_visitor<bool> {
         template <typename U, typename V>
         bool operator()(const U& first, const V& second) const {
@@ -870,6 +893,10 @@ auto Number::asSmallInt() const
     return boost::apply_visitor(MagicNumber::StrictCastVisitor<smallint>(), *value);
 }
 
+std::size_t Number::hash() const {
+    return boost::apply_visitor(MagicNumber::HashVisitor(), *value);
+}
+
 auto Number::hierarchyLevel() const
     -> hierarchy_t {
     return (hierarchy_t)boost::apply_visitor(MagicNumber::LevelVisitor(), *value);
@@ -291,6 +291,13 @@ public:
     /// \return the casted value
     smallint asSmallInt() const;
 
+    /// Returns a hash value for the number. Numbers which compare
+    /// equal have the same hash value, even if they belong to
+    /// different levels of the numerical hierarchy.
+    ///
+    /// \return the hash value
+    std::size_t hash() const;
+
     /// Returns a numerical value corresponding to the level of the
     /// hierarchy that the value belongs to, with 0 being the
     /// narrowest type (small integer) and 4 being the largest
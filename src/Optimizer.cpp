@@ -3,12 +3,232 @@
 
 
 #include "Optimizer.hpp"
+#include "Assembler.hpp"
 #include "Symbol.hpp"
 
+#include <bitset>
 #include <iostream>
 
 namespace optimize {
 
+    namespace {
+
+        Level currentLevel = Level::FULL;
+
+        using RegSet = std::bitset<32>;
+
+        /// The register-level effects of a single instruction. `writes`
+        /// contains every register which the instruction may modify,
+        /// while `kills` contains only those which it unconditionally
+        /// overwrites. An instruction is `pure` if it has no effects
+        /// other than those listed in `kills`.
+        struct Effects {
+            RegSet reads, writes, kills;
+            bool barrier, pure;
+        };
+
+        RegSet regs(std::initializer_list<Reg> list) {
+            RegSet result;
+            for (Reg r : list)
+                result.set((int)r);
+            return result;
+        }
+
+        Effects barrier() {
+            return { RegSet().set(), RegSet().set(), RegSet(), true, false };
+        }
+
+        Effects pure(RegSet reads, RegSet kills) {
+            return { reads, kills, kills, false, true };
+        }
+
+        Effects impure(RegSet reads, RegSet writes, RegSet kills = RegSet()) {
+            return { reads, writes | kills, kills, false, false };
+        }
+
+        bool isObjectReg(Reg reg) {
+            return (reg == Reg::PTR) || (reg == Reg::SLF) || (reg == Reg::RET);
+        }
+
+        bool isStackReg(Reg reg) {
+            return (reg == Reg::LEX) || (reg == Reg::DYN) || (reg == Reg::ARG) ||
+                (reg == Reg::STO) || (reg == Reg::HAND);
+        }
+
+        Reg regArg(const AssemblerLine& line, int n) {
+            if ((std::size_t)n >= line.argumentCount())
+                return Reg::CONT; // Never a valid operand to anything we inspect
+            RegisterArg arg = line.argument(n);
+            const Reg* reg = boost::get<Reg>(&arg);
+            return reg ? *reg : Reg::CONT;
+        }
+
+        Effects effects(const AssemblerLine& line) {
+            switch (line.getCommand()) {
+            case Instr::MOV: {
+                Reg src = regArg(line, 0), dest = regArg(line, 1);
+                if (!isObjectReg(src) || !isObjectReg(dest))
+                    return barrier();
+                return pure(regs({ src }), regs({ dest }));
+            }
+            case Instr::PUSH: {
+                Reg src = regArg(line, 0), stack = regArg(line, 1);
+                if (!isObjectReg(src) || !isStackReg(stack))
+                    return barrier();
+                return impure(regs({ src, stack }), regs({ stack }));
+            }
+            case Instr::POP:
+            case Instr::PEEK: {
+                Reg dest = regArg(line, 0), stack = regArg(line, 1);
+                if (!isObjectReg(dest) || !isStackReg(stack))
+                    return barrier();
+                return impure(regs({ stack }), regs({ dest, stack, Reg::ERR0 }));
+            }
+            case Instr::GETL:
+                return impure(regs({ Reg::LEX }), regs({ regArg(line, 0), Reg::ERR0 }));
+            case Instr::GETD:
+                return impure(regs({ Reg::DYN }), regs({ regArg(line, 0), Reg::ERR0 }));
+            case Instr::ESWAP:
+                return pure(regs({ Reg::ERR0, Reg::ERR1 }), regs({ Reg::ERR0, Reg::ERR1 }));
+            case Instr::ECLR:
+            case Instr::ESET:
+                return pure(RegSet(), regs({ Reg::ERR0 }));
+            case Instr::SYM:
+            case Instr::SYMN:
+                return pure(RegSet(), regs({ Reg::SYM }));
+            case Instr::NUM:
+            case Instr::INT:
+            case Instr::FLOAT:
+            case Instr::CMPLX:
+                return pure(RegSet(), regs({ Reg::NUM0 }));
+            case Instr::NSWAP:
+                return pure(regs({ Reg::NUM0, Reg::NUM1 }), regs({ Reg::NUM0, Reg::NUM1 }));
+            case Instr::STR:
+                return pure(RegSet(), regs({ Reg::STR0 }));
+            case Instr::SSWAP:
+                return pure(regs({ Reg::STR0, Reg::STR1 }), regs({ Reg::STR0, Reg::STR1 }));
+            case Instr::ADDS:
+                return pure(regs({ Reg::STR0, Reg::STR1 }), regs({ Reg::STR0 }));
+            case Instr::ARITH:
+                return impure(regs({ Reg::NUM0, Reg::NUM1 }), regs({ Reg::NUM0, Reg::ERR0 }));
+            case Instr::CLONE:
+                return pure(regs({ Reg::SLF }), regs({ Reg::RET }));
+            case Instr::RTRVD:
+                return impure(regs({ Reg::SLF, Reg::SYM }), regs({ Reg::RET, Reg::ERR0 }));
+            case Instr::EXPD:
+                return impure(regs({ Reg::PTR }), regs({ regArg(line, 0), Reg::ERR0 }));
+            case Instr::LOAD:
+                return impure(regs({ regArg(line, 0), Reg::PTR }), regs({ Reg::ERR0 }));
+            case Instr::MTHD:
+                return pure(regs({ Reg::TRNS }), regs({ Reg::MTHD }));
+            case Instr::MSWAP:
+                return pure(regs({ Reg::MTHD, Reg::MTHDZ }), regs({ Reg::MTHD, Reg::MTHDZ }));
+            case Instr::TEST:
+                return pure(regs({ Reg::SLF, Reg::PTR }), regs({ Reg::FLAG }));
+            case Instr::BOL:
+                return pure(regs({ Reg::FLAG }), regs({ Reg::RET }));
+            case Instr::LOCFN:
+                return impure(RegSet(), RegSet(), regs({ Reg::FILE }));
+            case Instr::LOCLN:
+                return impure(RegSet(), RegSet(), regs({ Reg::LINE }));
+            case Instr::YLD:
+            case Instr::YLDC:
+                return impure(regs({ Reg::LIT }), regs({ regArg(line, 1), Reg::ERR0 }));
+            case Instr::ARR:
+                return impure(regs({ Reg::ARG }), regs({ Reg::ARG }), regs({ Reg::RET }));
+            default:
+                // Anything that can call, throw, or jump is a barrier.
+                return barrier();
+            }
+        }
+
+        /// Parses the argument to a `num` instruction, returning true
+        /// and storing the result if the value's magnitude is at most
+        /// 0xFFFFFFFF. That is the range the scanner sends to `int`,
+        /// and the most that a long instruction argument keeps when
+        /// it is serialized.
+        bool parseSmallInteger(const std::string& str, long& out) {
+            if (str.empty())
+                return false;
+            unsigned long radix;
+            switch (str[0]) {
+            case 'D': radix = 10; break;
+            case 'X': radix = 16; break;
+            case 'O': radix =  8; break;
+            case 'B': radix =  2; break;
+            default: return false;
+            }
+            std::size_t i = 1;
+            bool negative = false;
+            if ((i < str.size()) && ((str[i] == '+') || (str[i] == '-'))) {
+                negative = (str[i] == '-');
+                ++i;
+            }
+            unsigned long accum = 0;
+            for (; i < str.size(); i++) {
+                char ch = str[i];
+                unsigned long value;
+                if ((ch >= '0') && (ch <= '9'))
+                    value = ch - '0';
+                else if ((ch >= 'A') && (ch <= 'Z'))
+                    value = ch - 'A' + 10;
+                else if ((ch >= 'a') && (ch <= 'z'))
+                    value = ch - 'a' + 10;
+                else
+                    return false;
+                if (value >= radix)
+                    return false;
+                if (accum > (0xFFFFFFFFUL - value) / radix)
+                    return false;
+                accum = accum * radix + value;
+            }
+            out = negative ? - (long)accum : (long)accum;
+            return true;
+        }
+
+    }
+
+    Pipeline& Pipeline::add(Pass pass) {
+        passes.push_back(pass);
+        return *this;
+    }
+
+    std::size_t Pipeline::size() const noexcept {
+        return passes.size();
+    }
+
+    void Pipeline::run(InstrSeq& seq) const {
+        for (const Pass& pass : passes)
+            pass(seq);
+    }
+
+    void Pipeline::run(TranslationUnitPtr unit) const {
+        for (int i = 0; i < unit->methodCount(); i++)
+            run(unit->method(i));
+    }
+
+    Pipeline standardPipeline(Level level) {
+        Pipeline result;
+        if (level >= Level::BASIC) {
+            result.add(foldConstants)
+                  .add(removeRedundantClears)
+                  .add(fusePushPop);
+        }
+        if (level >= Level::FULL) {
+            result.add(removeRedundantMoves)
+                  .add(eliminateDeadRegisters);
+        }
+        return result;
+    }
+
+    Level getLevel() noexcept {
+        return currentLevel;
+    }
+
+    void setLevel(Level level) noexcept {
+        currentLevel = level;
+    }
+
     void lookupSymbols(TranslationUnitPtr unit) {
         for (int i = 0; i < unit->methodCount(); i++) {
             InstrSeq& seq { unit->method(i) };
@@ -27,4 +247,179 @@ namespace optimize {
         }
     }
 
+    void fuseInstructions(TranslationUnitPtr unit) {
+        auto matches = [](const AssemblerLine& line, Instr instr, Reg a, Reg b) {
+            return (line.getCommand() == instr) && (regArg(line, 0) == a) && (regArg(line, 1) == b);
+        };
+        auto hasLong = [](const AssemblerLine& line) {
+            return (line.argumentCount() == 1) && isLongRegisterArg(line.argument(0));
+        };
+        for (int i = 0; i < unit->methodCount(); i++) {
+            InstrSeq& seq { unit->method(i) };
+            InstrSeq result;
+            for (std::size_t j = 0; j < seq.size(); j++) {
+                if (j + 2 < seq.size()) {
+                    const AssemblerLine& a = seq[j];
+                    const AssemblerLine& b = seq[j + 1];
+                    const AssemblerLine& c = seq[j + 2];
+                    if ((a.getCommand() == Instr::GETD) && (regArg(a, 0) == Reg::SLF) &&
+                        (b.getCommand() == Instr::SYMN) && hasLong(b) && (c.getCommand() == Instr::RTRV)) {
+                        // getd %slf; symn n; rtrv
+                        result.push_back(makeAssemblerLine(Instr::ARGLD, boost::get<long>(b.argument(0))));
+                        j += 2;
+                        continue;
+                    }
+                    if ((a.getCommand() == Instr::SYMN) && hasLong(a) && matches(b, Instr::MOV, Reg::RET, Reg::SLF) &&
+                        (c.getCommand() == Instr::RTRV)) {
+                        // symn n; mov %ret %slf; rtrv
+                        result.push_back(makeAssemblerLine(Instr::RTRVR, boost::get<long>(a.argument(0))));
+                        j += 2;
+                        continue;
+                    }
+                    if (matches(a, Instr::MOV, Reg::RET, Reg::PTR) && matches(b, Instr::POP, Reg::SLF, Reg::STO) &&
+                        (c.getCommand() == Instr::CALL) && hasLong(c)) {
+                        // mov %ret %ptr; pop %slf %sto; call n
+                        result.push_back(makeAssemblerLine(Instr::CALLR, boost::get<long>(c.argument(0))));
+                        j += 2;
+                        continue;
+                    }
+                }
+                result.push_back(seq[j]);
+            }
+            seq = std::move(result);
+        }
+    }
+
+    void foldConstants(InstrSeq& seq) {
+        for (AssemblerLine& line : seq) {
+            if (line.getCommand() != Instr::NUM)
+                continue;
+            RegisterArg arg = line.argument(0);
+            auto str = boost::get<std::string>(&arg);
+            long value;
+            if (str && parseSmallInteger(*str, value)) {
+                line.setCommand(Instr::INT);
+                line.clearRegisterArgs();
+                line.addRegisterArg(value);
+            }
+        }
+    }
+
+    void removeRedundantClears(InstrSeq& seq) {
+        // Nothing is known about %err0 on entry to a sequence.
+        bool clear = false;
+        for (auto iter = seq.begin(); iter != seq.end(); ) {
+            Instr instr = iter->getCommand();
+            if (instr == Instr::ECLR) {
+                if (clear) {
+                    iter = seq.erase(iter);
+                    continue;
+                }
+                clear = true;
+            } else if ((instr == Instr::THROA) || (instr == Instr::THROQ)) {
+                // Execution only falls through these if %err0 is false.
+                clear = true;
+            } else {
+                Effects eff = effects(*iter);
+                if (eff.barrier || eff.writes[(int)Reg::ERR0])
+                    clear = false;
+            }
+            ++iter;
+        }
+    }
+
+    void fusePushPop(InstrSeq& seq) {
+        for (std::size_t i = 0; i < seq.size(); i++) {
+            if (seq[i].getCommand() != Instr::PUSH)
+                continue;
+            Reg src = regArg(seq[i], 0), stack = regArg(seq[i], 1);
+            if (!isObjectReg(src) || !isStackReg(stack))
+                continue;
+            // Look for the matching pop, noting whether the source and
+            // destination registers are disturbed along the way.
+            bool srcWritten = false;
+            RegSet touched;
+            for (std::size_t j = i + 1; j < seq.size(); j++) {
+                if ((seq[j].getCommand() == Instr::POP) && (regArg(seq[j], 1) == stack)) {
+                    Reg dest = regArg(seq[j], 0);
+                    if (!isObjectReg(dest))
+                        break;
+                    if (!srcWritten) {
+                        // Move at the pop site; the source still holds the value.
+                        seq[j] = makeAssemblerLine(Instr::MOV, src, dest);
+                        seq.erase(seq.begin() + i);
+                        i--;
+                    } else if (!touched[(int)dest]) {
+                        // Move at the push site; nothing in between sees the destination.
+                        seq[i] = makeAssemblerLine(Instr::MOV, src, dest);
+                        seq.erase(seq.begin() + j);
+                    }
+                    break;
+                }
+                Effects eff = effects(seq[j]);
+                if (eff.barrier || eff.reads[(int)stack] || eff.writes[(int)stack])
+                    break;
+                srcWritten = srcWritten || eff.writes[(int)src];
+                touched |= eff.reads | eff.writes;
+            }
+        }
+    }
+
+    void removeRedundantMoves(InstrSeq& seq) {
+        // Value numbers for the object registers; two registers with
+        // the same number are known to hold the same object.
+        long next = 0;
+        long ptr = next++, slf = next++, ret = next++;
+        auto number = [&ptr, &slf, &ret](Reg reg) -> long& {
+            switch (reg) {
+            case Reg::PTR:
+                return ptr;
+            case Reg::SLF:
+                return slf;
+            default:
+                return ret;
+            }
+        };
+        for (auto iter = seq.begin(); iter != seq.end(); ) {
+            Effects eff = effects(*iter);
+            if (eff.barrier) {
+                ptr = next++;
+                slf = next++;
+                ret = next++;
+            } else if (iter->getCommand() == Instr::MOV) {
+                Reg src = regArg(*iter, 0), dest = regArg(*iter, 1);
+                if (number(src) == number(dest)) {
+                    iter = seq.erase(iter);
+                    continue;
+                }
+                number(dest) = number(src);
+            } else {
+                for (Reg reg : { Reg::PTR, Reg::SLF, Reg::RET }) {
+                    if (eff.writes[(int)reg])
+                        number(reg) = next++;
+                }
+            }
+            ++iter;
+        }
+    }
+
+    void eliminateDeadRegisters(InstrSeq& seq) {
+        // Everything is assumed to be live at the end of the sequence,
+        // since the caller may inspect any register.
+        RegSet live;
+        live.set();
+        for (auto iter = seq.end(); iter != seq.begin(); ) {
+            --iter;
+            Effects eff = effects(*iter);
+            if (eff.barrier) {
+                live.set();
+            } else if (eff.pure && (eff.writes & live).none()) {
+                iter = seq.erase(iter);
+            } else {
+                live &= ~eff.kills;
+                live |= eff.reads;
+            }
+        }
+    }
+
 }
@@ -5,11 +5,145 @@
 #define OPTIMIZER_HPP
 
 #include "Instructions.hpp"
+#include <functional>
+#include <vector>
+
+/// \file
+///
+/// \brief Bytecode-level optimization passes.
+///
+/// With the exception of #optimize::lookupSymbols, which depends on
+/// the state of the running symbol table, every pass in this file
+/// operates on a single instruction sequence and produces code which
+/// is safe to serialize, so the passes run when a file is compiled
+/// and the resulting `.latc` file is already optimized.
+///
+/// All of the peephole passes are deliberately conservative. Any
+/// instruction which may transfer control (calls, `rtrv`, `cpp`,
+/// throws, continuation jumps, etc.) is treated as a barrier which
+/// reads and writes every register, so the passes only ever reason
+/// about straight-line runs of simple register instructions.
 
 namespace optimize {
 
+    /// \brief The level of optimization to perform on compiled code.
+    enum class Level : int {
+
+        /// Perform no bytecode optimization.
+        NONE = 0,
+
+        /// Perform only local rewrites which never remove a write to
+        /// a register: constant folding, redundant `eclr` removal,
+        /// and push/pop fusion.
+        BASIC = 1,
+
+        /// Perform every available optimization, including copy
+        /// propagation and dead register elimination.
+        FULL = 2
+
+    };
+
+    /// \brief An optimization pass, which rewrites a single
+    /// instruction sequence in-place.
+    using Pass = std::function<void(InstrSeq&)>;
+
+    /// \brief An ordered collection of optimization passes.
+    class Pipeline {
+    private:
+        std::vector<Pass> passes;
+    public:
+
+        /// Appends a pass to the end of the pipeline.
+        ///
+        /// \param pass the pass
+        /// \return the pipeline itself
+        Pipeline& add(Pass pass);
+
+        /// \return the number of passes in the pipeline
+        std::size_t size() const noexcept;
+
+        /// Runs every pass, in order, on the instruction sequence.
+        ///
+        /// \param seq the instruction sequence
+        void run(InstrSeq& seq) const;
+
+        /// Runs every pass, in order, on each instruction sequence in
+        /// the translation unit.
+        ///
+        /// \param unit the translation unit
+        void run(TranslationUnitPtr unit) const;
+
+    };
+
+    /// Constructs the standard pipeline of passes for the given
+    /// optimization level.
+    ///
+    /// \param level the optimization level
+    /// \return the pipeline
+    Pipeline standardPipeline(Level level);
+
+    /// Returns the optimization level used when compiling Latitude
+    /// source files. The level defaults to Level::FULL.
+    ///
+    /// \return the current optimization level
+    Level getLevel() noexcept;
+
+    /// Sets the optimization level used when compiling Latitude
+    /// source files.
+    ///
+    /// \param level the new optimization level
+    void setLevel(Level level) noexcept;
+
+    /// Replaces every `sym` instruction whose symbol is not generated
+    /// with the equivalent `symn` instruction. Symbol indices are
+    /// only meaningful to the running VM, so this pass must be run
+    /// when code is loaded, not when it is compiled.
+    ///
+    /// \param unit the translation unit
     void lookupSymbols(TranslationUnitPtr unit);
 
+    /// Replaces common instruction sequences with the equivalent
+    /// superinstruction (`argld`, `rtrvr`, or `callr`), reducing the
+    /// number of instructions dispatched. Since the superinstructions
+    /// take symbol indices, this pass should be run after
+    /// #lookupSymbols, when code is loaded.
+    ///
+    /// \param unit the translation unit
+    void fuseInstructions(TranslationUnitPtr unit);
+
+    /// Rewrites `num` instructions whose value fits in a small
+    /// integer into the equivalent `int` instruction, so that the
+    /// literal need not be parsed at runtime.
+    ///
+    /// \param seq the instruction sequence
+    void foldConstants(InstrSeq& seq);
+
+    /// Removes `eclr` instructions which occur at a point where
+    /// `%%err0` is already known to be false, such as immediately
+    /// after a previous `eclr` or a `throa`.
+    ///
+    /// \param seq the instruction sequence
+    void removeRedundantClears(InstrSeq& seq);
+
+    /// Replaces a `push` onto a stack followed, in the same
+    /// straight-line run, by a `pop` from that stack with a single
+    /// `mov`, provided nothing in between touches the stack.
+    ///
+    /// \param seq the instruction sequence
+    void fusePushPop(InstrSeq& seq);
+
+    /// Removes `mov` instructions whose source and destination are
+    /// already known to contain the same object.
+    ///
+    /// \param seq the instruction sequence
+    void removeRedundantMoves(InstrSeq& seq);
+
+    /// Removes side-effect-free instructions whose only effect is to
+    /// write a register that is overwritten before it is ever read.
+    ///
+    /// \param seq the instruction sequence
+    void eliminateDeadRegisters(InstrSeq& seq);
+
 }
 
 #endif // OPTIMIZER_HPP
@@ -91,6 +91,10 @@
         void yyerror(const char*);
         struct Expr* makeExpr();
         struct List* makeList();
+        struct Expr* allocExpr();
+        struct List* allocList();
+        bool inParseArena();
+        void emitLine(struct Expr* stmt);
     #ifdef __cplusplus
     }
     #endif
@@ -109,7 +113,6 @@
 
 %error-verbose
 
-%type <argval> lines
 %type <exprval> line
 %type <exprval> stmt
 %type <exprval> rhs
@@ -152,11 +155,12 @@
 %%
 
 toplevel:
-    lines { setCurrentLine($1); }
+    lines
     ;
 lines:
-    line lines { $$ = makeList(); $$->car = $1; $$->cdr = $2; } |
-    /* empty */ { $$ = makeList(); }
+    lines line { emitLine($2); } |
+    /* empty */
+    ;
 line:
     stmt '.'
     ;
@@ -354,6 +358,8 @@ void yyerror(const char* str) {
 }
 
 void cleanupE(struct Expr* stmt) {
+    if (inParseArena())
+        return; // The arena releases its nodes in bulk
     if (stmt->lhs != 0) {
         cleanupE(stmt->lhs);
         free(stmt->lhs);
@@ -371,6 +377,8 @@ void cleanupE(struct Expr* stmt) {
 }
 
 void cleanupL(struct List* stmt) {
+    if (inParseArena())
+        return; // The arena releases its nodes in bulk
     if (stmt->car != 0) {
         cleanupE(stmt->car);
         free(stmt->car);
@@ -382,7 +390,7 @@ void cleanupL(struct List* stmt) {
 }
 
 struct Expr* makeExpr() {
-    struct Expr* expr = new Expr();
+    struct Expr* expr = allocExpr();
     // TODO This +1 correction seems to be only necessary in specifically repl.lats... :/
     //expr->line = line_num + 1;
     expr->line = line_num;
@@ -390,7 +398,7 @@ struct Expr* makeExpr() {
 }
 
 struct List* makeList() {
-    return new List();
+    return allocList();
 }
 
 }
@@ -28,12 +28,21 @@ struct OpTree {
 using op_pair_t = std::pair<ListElem, std::string>;
 
 OperatorTable::OperatorTable(ObjectPtr table)
-    : impl(table) {}
+    : impl(table), cache(std::make_shared< std::unordered_map<std::string, OperatorData> >()) {}
 
 OperatorData OperatorTable::lookup(std::string op) const {
+    auto iter = cache->find(op);
+    if (iter != cache->end())
+        return iter->second;
+    OperatorData result = resolve(op);
+    cache->emplace(std::move(op), result);
+    return result;
+}
+
+OperatorData OperatorTable::resolve(const std::string& op) const {
 
-    Symbolic name = Symbols::get()[op];
-    ObjectPtr val = objectGet(impl, name);
+    auto store = boost::get<DictStore>(&impl->prim());
+    ObjectPtr val = (store != nullptr) ? store->get(Symbols::get()[op]) : nullptr;
 
     // Doesn't exist? Fine, just use the default.
     if (val == nullptr)
@@ -266,8 +275,7 @@ OperatorTable getTable(ObjectPtr lex) {
     ObjectPtr table = objectGet(meta, Symbols::get()["operators"]);
     if (table == nullptr)
         throw ParseError("Could not find operator table");
-    ObjectPtr impl = objectGet(table, Symbols::get()["&impl"]);
-    if (impl == nullptr)
+    if (boost::get<DictStore>(&table->prim()) == nullptr)
         throw ParseError("Could not find operator table");
-    return OperatorTable(impl);
+    return OperatorTable(table);
 }
@@ -6,6 +6,9 @@
 
 #include "Proto.hpp"
 #include "Parser.tab.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 /// \file
 /// \brief Classes and functions for resolving Latitude operator precedence
@@ -41,17 +44,28 @@ struct OperatorData {
 };
 
 /// The operator table itself. OperatorTable instances perform lookups
-/// in the implementing table object, which is passed to the
-/// constructor.
+/// in the operator dictionary, which is passed to the constructor.
+///
+/// An OperatorTable is a snapshot of the table object. The first
+/// lookup of each operator walks the table object, and its result is
+/// remembered in a flat hash map, so that the rest of the parse pays
+/// only for a single string lookup. No Latitude code runs while a
+/// parse is in progress, so the table object cannot change underneath
+/// the snapshot; a later call to getTable() produces a fresh snapshot
+/// reflecting any changes made since. Copies of an OperatorTable
+/// share the same snapshot.
 class OperatorTable {
 private:
     ObjectPtr impl;
+    std::shared_ptr< std::unordered_map<std::string, OperatorData> > cache;
+
+    OperatorData resolve(const std::string& op) const;
+
 public:
 
-    /// Constructs an OperatorTable from a non-null object pointer.
-    /// Note that the argument is *not* the dictionary object but its
-    /// internal implementation object, which should be a "fresh"
-    /// object.
+    /// Constructs an OperatorTable from a non-null object pointer,
+    /// which should be a dictionary whose keys are the operator
+    /// names, as symbols.
     ///
     /// \param table the table object
     explicit OperatorTable(ObjectPtr table);
@@ -7,22 +7,73 @@
 
 using namespace std;
 
+// The indices of the streams which are ready for reading right now.
+static vector<size_t> readyStreams(const vector<StreamPtr>& streams) {
+    vector<size_t> ready;
+    for (size_t i = 0; i < streams.size(); i++) {
+        if (streams[i]->isReady())
+            ready.push_back(i);
+    }
+    return ready;
+}
+
 #ifdef USE_POSIX
 #include <mutex>
+#include <cerrno>
+#include <chrono>
+#include <algorithm>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
 #include <unistd.h>
 #include <sys/wait.h>
+#include <system_error>
+
+extern char** environ;
 
 class UnixProcess;
 
-class FilePtrStream : public Stream {
+// A pipe to or from a child process. Reads go through the buffer of
+// BufferedStream, but writes are passed straight through, since the
+// child may be waiting on them before it produces any more output.
+class FilePtrStream : public BufferedStream {
 private:
     int fd;
     bool isIn;
     bool isOut;
-    bool eof;
+protected:
+    virtual size_t readRaw(char* buf, size_t n) {
+        if (fd < 0)
+            return 0;
+        ssize_t count;
+        do {
+            count = ::read(fd, buf, n);
+        } while ((count < 0) && (errno == EINTR));
+        return (count < 0) ? 0 : count;
+    }
+    virtual bool rawReady() {
+        if (fd < 0)
+            return true;
+        pollfd entry { fd, POLLIN, 0 };
+        return poll(&entry, 1, 0) != 0;
+    }
+    virtual void writeRaw(const char* buf, size_t n) {
+        while ((n > 0) && (fd >= 0)) {
+            ssize_t count = ::write(fd, buf, n);
+            if ((count < 0) && (errno == EINTR))
+                continue;
+            if (count <= 0) {
+                // Not good
+                close();
+                return;
+            }
+            buf += count;
+            n -= count;
+        }
+    }
 public:
     FilePtrStream(int file, bool in, bool out)
-        : fd(file), isIn(in), isOut(out), eof(false) {}
+        : BufferedStream(), fd(file), isIn(in), isOut(out) {}
     virtual ~FilePtrStream() {
         close();
     }
@@ -33,22 +84,19 @@ public:
         return isIn;
     }
     virtual void out(char ch) {
-        if (write(fd, &ch, 1) == 0) {
-            // Not good
-            close();
-        }
+        writeRaw(&ch, 1);
     }
-    virtual char in() {
-        char ch;
-        if (read(fd, &ch, 1) == 0)
-            eof = true;
-        return ch;
-    }
-    virtual bool isEof() const noexcept {
-        return eof;
+    virtual void write(const char* buf, size_t n) {
+        writeRaw(buf, n);
     }
     virtual void close() {
-        ::close(fd);
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    int descriptor() const noexcept {
+        return fd;
     }
 };
 
@@ -63,6 +111,8 @@ private:
 public:
     UnixProcess(string cmd)
         : Process(cmd) , pid(0), flagged(false), done(false), exitCode(-1) {}
+    UnixProcess(vector<string> args)
+        : Process(args) , pid(0), flagged(false), done(false), exitCode(-1) {}
     virtual bool isRunning() {
         refreshCodes();
         return (pid != 0) && (!done);
@@ -90,10 +140,17 @@ void UnixProcess::refreshCodes() {
                 done = true;
                 exitCode = -1;
             } else {
-                // Terminated; flag and stop
+                // Terminated; flag and stop. A process killed by a
+                // signal reports 128 plus the signal number, as in
+                // the shell.
                 flagged = true;
                 done = true;
-                exitCode = status;
+                if (WIFEXITED(status))
+                    exitCode = WEXITSTATUS(status);
+                else if (WIFSIGNALED(status))
+                    exitCode = 128 + WTERMSIG(status);
+                else
+                    exitCode = -1;
             }
         }
     }
@@ -102,51 +159,64 @@ void UnixProcess::refreshCodes() {
 int UnixProcess::_run() {
     constexpr int READ = 0;
     constexpr int WRITE = 1;
-    int sIn[2];
-    int sOut[2];
-    int sErr[2];
-    if (pipe(sIn) < 0)
-        return 1;
-    if (pipe(sOut) < 0)
-        return 1;
-    if (pipe(sErr) < 0)
-        return 1;
-    int pid_ = fork();
-    if (pid_ == 0) {
-        // We are in the child process
-        dup2(sIn[READ], STDIN_FILENO);
-        dup2(sOut[WRITE], STDOUT_FILENO);
-        dup2(sErr[WRITE], STDERR_FILENO);
-
-        close(sIn[READ]);
+    int fds[6];
+    int* sIn = fds;
+    int* sOut = fds + 2;
+    int* sErr = fds + 4;
+    for (int i = 0; i < 6; i += 2) {
+        if (pipe(fds + i) < 0) {
+            for (int j = 0; j < i; j++)
+                close(fds[j]);
+            return 1;
+        }
+    }
+    // None of the pipes should leak into this child or any later
+    // one; the child's own ends are dup'ed onto the standard streams
+    // below, which clears the flag on the copies.
+    for (int fd : fds)
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, sIn[READ], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, sOut[WRITE], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, sErr[WRITE], STDERR_FILENO);
+
+    // Either run the program directly or hand the command line to
+    // the shell, but in both cases without an intermediate fork.
+    vector<string> argv0 = args;
+    if (argv0.empty())
+        argv0 = { "sh", "-c", cmd };
+    vector<char*> argv;
+    for (string& arg : argv0)
+        argv.push_back(&arg[0]);
+    argv.push_back(nullptr);
+
+    pid_t pid_;
+    int result;
+    if (args.empty())
+        result = posix_spawn(&pid_, "/bin/sh", &actions, nullptr, argv.data(), environ);
+    else
+        result = posix_spawnp(&pid_, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    // Close the unused buffers
+    close(sIn[READ]);
+    close(sOut[WRITE]);
+    close(sErr[WRITE]);
+
+    if (result != 0) {
         close(sIn[WRITE]);
         close(sOut[READ]);
-        close(sOut[WRITE]);
         close(sErr[READ]);
-        close(sErr[WRITE]);
-
-        int code = system(cmd.c_str());
-
-        close(STDIN_FILENO);
-        close(STDOUT_FILENO);
-        close(STDERR_FILENO);
-
-        exit(code);
-
-    } else if (pid_ < 0) {
         return 1; // Something bad happened
-    } else {
-        // Close the unused buffers
-        close(sIn[READ]);
-        close(sOut[WRITE]);
-        close(sErr[WRITE]);
+    }
 
-        this->in  = StreamPtr( new FilePtrStream(sIn [WRITE], false, true ) );
-        this->out = StreamPtr( new FilePtrStream(sOut[READ ], true , false) );
-        this->err = StreamPtr( new FilePtrStream(sErr[READ ], true , false) );
-        this->pid = pid_;
+    this->in  = StreamPtr( new FilePtrStream(sIn [WRITE], false, true ) );
+    this->out = StreamPtr( new FilePtrStream(sOut[READ ], true , false) );
+    this->err = StreamPtr( new FilePtrStream(sErr[READ ], true , false) );
+    this->pid = pid_;
 
-    }
     return 0;
 }
 
@@ -154,21 +224,73 @@ ProcessPtr makeProcess(string cmd) {
     return ProcessPtr(new UnixProcess(cmd));
 }
 
+ProcessPtr makeProcess(vector<string> args) {
+    return ProcessPtr(new UnixProcess(args));
+}
+
+vector<size_t> pollStreams(const vector<StreamPtr>& streams, long timeout) {
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout);
+    vector<size_t> ready = readyStreams(streams);
+    while (ready.empty() && (!streams.empty())) {
+        // Only pipes and standard input can be waited on; every other
+        // stream is always ready, so if there are any, readyStreams has
+        // found them.
+        vector<pollfd> fds;
+        for (const StreamPtr& stream : streams) {
+            if (auto pipe = dynamic_cast<FilePtrStream*>(stream.get()))
+                fds.push_back({ pipe->descriptor(), POLLIN, 0 });
+            else if (dynamic_cast<CinStream*>(stream.get()))
+                fds.push_back({ 0, POLLIN, 0 });
+        }
+        int wait = -1;
+        if (timeout >= 0) {
+            auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+            wait = max(0L, (long)left.count());
+        }
+        int result = poll(fds.data(), fds.size(), wait);
+        if ((result < 0) && (errno != EINTR))
+            throw system_error(errno, generic_category(), "poll");
+        ready = readyStreams(streams);
+        if ((result == 0) && (wait >= 0))
+            break;
+    }
+    return ready;
+}
+
 #endif // USE_POSIX
 
 #ifdef USE_WINDOWS
 #define WINVER 0x0500
 #include <windows.h>
 
-class HandleStream : public Stream {
+// The Windows counterpart of FilePtrStream.
+class HandleStream : public BufferedStream {
 private:
     HANDLE handle;
     bool isIn;
     bool isOut;
-    bool eof;
+protected:
+    virtual size_t readRaw(char* buf, size_t n) {
+        DWORD result;
+        if ((handle == nullptr) || (!ReadFile(handle, buf, n, &result, NULL)))
+            return 0;
+        return result;
+    }
+    virtual bool rawReady() {
+        DWORD available;
+        // A broken pipe is at its end, and so ready.
+        if ((handle == nullptr) || (!PeekNamedPipe(handle, NULL, 0, NULL, &available, NULL)))
+            return true;
+        return available > 0;
+    }
+    virtual void writeRaw(const char* buf, size_t n) {
+        DWORD ignore; // The system requires that this be non-null for some reason
+        if (handle != nullptr)
+            WriteFile(handle, buf, n, &ignore, NULL);
+    }
 public:
     HandleStream(HANDLE file, bool in, bool out)
-        : handle(file), isIn(in), isOut(out), eof(false) {}
+        : BufferedStream(), handle(file), isIn(in), isOut(out) {}
     virtual ~HandleStream() {
         close();
     }
@@ -179,22 +301,16 @@ public:
         return isIn;
     }
     virtual void out(char ch) {
-        DWORD ignore; // The system requires that this be non-null for some reason
-        WriteFile(handle, &ch, 1, &ignore, NULL);
+        writeRaw(&ch, 1);
     }
-    virtual char in() {
-        DWORD result;
-        char ch;
-        ReadFile(handle, &ch, 1, &result, NULL);
-        if (result == 0)
-            eof = true;
-        return ch;
-    }
-    virtual bool isEof() const noexcept {
-        return eof;
+    virtual void write(const char* buf, size_t n) {
+        writeRaw(buf, n);
     }
     virtual void close() {
-        CloseHandle(handle);
+        if (handle != nullptr) {
+            CloseHandle(handle);
+            handle = nullptr;
+        }
     }
 };
 
@@ -209,6 +325,8 @@ private:
 public:
     WindowsProcess(string cmd)
         : Process(cmd), handle(nullptr), flagged(false), done(false), exitCode(-1) {}
+    WindowsProcess(vector<string> args)
+        : Process(args), handle(nullptr), flagged(false), done(false), exitCode(-1) {}
     virtual ~WindowsProcess() {
         if (handle)
             CloseHandle(handle);
@@ -253,6 +371,36 @@ void CALLBACK waitCallback(PVOID param, BOOLEAN fired) {
     delete triple;
 }
 
+// Builds a command line which CommandLineToArgvW will split back into
+// the given arguments.
+string joinArguments(const vector<string>& args) {
+    string result;
+    for (const string& arg : args) {
+        if (!result.empty())
+            result += ' ';
+        if ((!arg.empty()) && (arg.find_first_of(" \t\"") == string::npos)) {
+            result += arg;
+            continue;
+        }
+        result += '"';
+        size_t slashes = 0;
+        for (char ch : arg) {
+            if (ch == '\\') {
+                ++slashes;
+            } else {
+                // Backslashes are only special before a quote.
+                if (ch == '"')
+                    result.append(slashes + 1, '\\');
+                slashes = 0;
+            }
+            result += ch;
+        }
+        result.append(slashes, '\\');
+        result += '"';
+    }
+    return result;
+}
+
 int WindowsProcess::_run() {
     HANDLE inPipeRd, inPipeWr, outPipeRd, outPipeWr, errPipeRd, errPipeWr;
     SECURITY_ATTRIBUTES attr;
@@ -284,7 +432,7 @@ int WindowsProcess::_run() {
     start.hStdInput = inPipeRd;
     start.dwFlags = STARTF_USESTDHANDLES;
 
-    string temp(cmd);
+    string temp = args.empty() ? cmd : joinArguments(args);
     char* buffer = new char[temp.size() + 1];
     strcpy(buffer, temp.c_str());
     BOOL success = CreateProcess(nullptr, buffer,
@@ -318,6 +466,21 @@ ProcessPtr makeProcess(string cmd) {
     return ProcessPtr(new WindowsProcess(cmd));
 }
 
+ProcessPtr makeProcess(vector<string> args) {
+    return ProcessPtr(new WindowsProcess(args));
+}
+
+vector<size_t> pollStreams(const vector<StreamPtr>& streams, long timeout) {
+    // Anonymous pipes cannot be waited on together, so poll them.
+    DWORD start = GetTickCount();
+    vector<size_t> ready = readyStreams(streams);
+    while (ready.empty() && ((timeout < 0) || (GetTickCount() - start < (DWORD)timeout))) {
+        Sleep(1);
+        ready = readyStreams(streams);
+    }
+    return ready;
+}
+
 #endif // USE_WINDOWS
 
 #ifdef USE_NULL
@@ -326,10 +489,21 @@ ProcessPtr makeProcess(string cmd) {
     return ProcessPtr();
 }
 
+ProcessPtr makeProcess(vector<string> args) {
+    return ProcessPtr();
+}
+
+vector<size_t> pollStreams(const vector<StreamPtr>& streams, long timeout) {
+    return readyStreams(streams);
+}
+
 #endif // USE_NULL
 
 Process::Process(std::string cmd)
-    : cmd(cmd), in(new NullStream()), out(new NullStream()), err(new NullStream()) {}
+    : cmd(cmd), args(), in(new NullStream()), out(new NullStream()), err(new NullStream()) {}
+
+Process::Process(std::vector<std::string> args)
+    : cmd(), args(args), in(new NullStream()), out(new NullStream()), err(new NullStream()) {}
 
 bool Process::run() {
     if ((!this->isDone()) && (!this->isRunning())) {
@@ -6,6 +6,7 @@
 
 #include "Stream.hpp"
 #include <string>
+#include <vector>
 
 /// \file
 ///
@@ -18,6 +19,7 @@
 class Process {
 protected:
     std::string cmd;
+    std::vector<std::string> args;
     StreamPtr in;
     StreamPtr out;
     StreamPtr err;
@@ -30,9 +32,19 @@ protected:
 
 public:
 
-    /// Constructs a process with the given name.
+    /// Constructs a process which will pass the given command line
+    /// to the system shell.
     Process(std::string cmd);
 
+    /// Constructs a process which will run the program named by the
+    /// first argument directly, without the involvement of a shell,
+    /// passing it the given arguments. The program is searched for on
+    /// the `PATH`.
+    ///
+    /// \param args the program name followed by its arguments; must
+    /// be nonempty
+    Process(std::vector<std::string> args);
+
     /// Destructs the Process instance.
     virtual ~Process() = default;
 
@@ -88,4 +100,28 @@ using ProcessPtr = std::shared_ptr<Process>;
 /// \return the process pointer
 ProcessPtr makeProcess(std::string cmd);
 
+/// Constructs a new process pointer for a process which will execute
+/// the given program directly with the given arguments. As with the
+/// string overload, this may return a null pointer on an unknown
+/// operating system.
+///
+/// \param args the program name followed by its arguments; must be
+/// nonempty
+/// \return the process pointer
+ProcessPtr makeProcess(std::vector<std::string> args);
+
+/// Waits until at least one of the given streams is ready for reading
+/// (in the sense of Stream::isReady) or until the timeout elapses,
+/// whichever comes first. Subprocess pipes are waited on together, so
+/// the output of many processes can be collected as it arrives
+/// without blocking on any one of them.
+///
+/// \param streams the streams
+/// \param timeout the timeout in milliseconds, or a negative number to
+/// wait indefinitely
+/// \return the indices (into `streams`) of the ready streams, in
+/// increasing order, which is empty only if the timeout elapsed
+/// \throw std::system_error if the streams cannot be waited on
+std::vector<std::size_t> pollStreams(const std::vector<StreamPtr>& streams, long timeout);
+
 #endif // PROCESS_HPP
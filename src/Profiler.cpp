@@ -0,0 +1,436 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#include "Profiler.hpp"
+#include "Bytecode.hpp"
+#include "Allocator.hpp"
+#include "Platform.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef USE_POSIX
+#include <sys/time.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_USE_RDTSC
+#endif
+
+using namespace std;
+
+InstrProfiler InstrProfiler::instance;
+
+unsigned long long readTicks() noexcept {
+#ifdef PROFILER_USE_RDTSC
+    return __rdtsc();
+#else
+    auto now = chrono::steady_clock::now().time_since_epoch();
+    return chrono::duration_cast<chrono::nanoseconds>(now).count();
+#endif
+}
+
+InstrProfiler::InstrProfiler()
+    : enabled(false), filename(), opcodes(), methods(), lines(),
+      currentInstr(), startTicks(0), currentMethod(nullptr), currentLine(nullptr),
+      lastSeq(nullptr), lastFile(), lastLine(0) {}
+
+InstrProfiler& InstrProfiler::get() noexcept {
+    return instance;
+}
+
+void InstrProfiler::start(string file) {
+    static bool registered = false;
+    filename = file;
+    enabled = true;
+    if (!registered) {
+        // Make sure the results are written even if the program exits
+        // without returning from main.
+        registered = true;
+        atexit([]() { InstrProfiler::get().stop(); });
+    }
+}
+
+void InstrProfiler::stop() {
+    if (!enabled)
+        return;
+    enabled = false;
+    ofstream out { filename };
+    if (!out) {
+        cerr << "Could not write profile data to " << filename << endl;
+        return;
+    }
+    writeReport(out);
+}
+
+void InstrProfiler::reset() {
+    opcodes.fill(Counter());
+    methods.clear();
+    lines.clear();
+    currentMethod = nullptr;
+    currentLine = nullptr;
+    lastSeq = nullptr;
+    lastFile.clear();
+    lastLine = 0;
+}
+
+void InstrProfiler::instructionBegin(VMState& vm, Instr instr) {
+    const InstrSeq* seq = &vm.state.cont.instructions();
+    if ((seq != lastSeq) || (currentMethod == nullptr)) {
+        auto iter = methods.find(seq);
+        if (iter == methods.end()) {
+            // First time we've seen this method, so describe it while
+            // the code is known to be alive.
+            Method& method = vm.state.cont.getMethod();
+            MethodRecord record { method.translationUnit(), method.index().index, "", 0, Counter() };
+            for (const AssemblerLine& line : *seq) {
+                if ((line.getCommand() == Instr::LOCFN) && record.file.empty())
+                    record.file = boost::get<string>(line.argument(0));
+                else if ((line.getCommand() == Instr::LOCLN) && (record.line == 0))
+                    record.line = boost::get<long>(line.argument(0));
+                if ((!record.file.empty()) && (record.line != 0))
+                    break;
+            }
+            iter = methods.emplace(seq, move(record)).first;
+        }
+        lastSeq = seq;
+        currentMethod = &iter->second.counter;
+    }
+    if ((vm.state.line != lastLine) || (vm.state.file != lastFile) || (currentLine == nullptr)) {
+        lastLine = vm.state.line;
+        lastFile = vm.state.file;
+        currentLine = &lines[make_pair(lastFile, lastLine)];
+    }
+    currentInstr = instr;
+    startTicks = readTicks();
+}
+
+void InstrProfiler::instructionEnd() noexcept {
+    unsigned long long elapsed = readTicks() - startTicks;
+    Counter& op = opcodes[(unsigned char)currentInstr];
+    ++op.count;
+    op.ticks += elapsed;
+    ++currentMethod->count;
+    currentMethod->ticks += elapsed;
+    ++currentLine->count;
+    currentLine->ticks += elapsed;
+}
+
+auto InstrProfiler::opcodeCounter(Instr instr) const -> Counter {
+    return opcodes[(unsigned char)instr];
+}
+
+auto InstrProfiler::lineCounter(const string& file, long line) const -> Counter {
+    auto iter = lines.find(make_pair(file, line));
+    if (iter == lines.end())
+        return Counter();
+    return iter->second;
+}
+
+void InstrProfiler::writeReport(ostream& out) const {
+    auto byTicks = [](const Counter& a, const Counter& b) {
+        return a.ticks > b.ticks;
+    };
+
+    Counter total;
+    for (const Counter& op : opcodes) {
+        total.count += op.count;
+        total.ticks += op.ticks;
+    }
+#ifdef PROFILER_USE_RDTSC
+    const char* unit = "cycles";
+#else
+    const char* unit = "ns";
+#endif
+    out << "# latitude-profile instructions=" << total.count
+        << " ticks=" << total.ticks << " unit=" << unit << "\n";
+
+    out << "[opcodes]\n";
+    out << "opcode\tname\tcount\tticks\n";
+    vector<int> ops;
+    for (int i = 0; i < 256; i++) {
+        if (opcodes[i].count > 0)
+            ops.push_back(i);
+    }
+    sort(ops.begin(), ops.end(), [&](int a, int b) { return byTicks(opcodes[a], opcodes[b]); });
+    for (int i : ops) {
+        out << i << "\t" << instructionName((Instr)i) << "\t"
+            << opcodes[i].count << "\t" << opcodes[i].ticks << "\n";
+    }
+
+    out << "[methods]\n";
+    out << "file\tline\tindex\tcount\tticks\n";
+    vector<const MethodRecord*> mthds;
+    for (const auto& entry : methods)
+        mthds.push_back(&entry.second);
+    sort(mthds.begin(), mthds.end(), [&](const MethodRecord* a, const MethodRecord* b) {
+        return byTicks(a->counter, b->counter);
+    });
+    for (const MethodRecord* record : mthds) {
+        out << (record->file.empty() ? "<builtin>" : record->file) << "\t" << record->line << "\t"
+            << record->index << "\t" << record->counter.count << "\t" << record->counter.ticks << "\n";
+    }
+
+    out << "[lines]\n";
+    out << "file\tline\tcount\tticks\n";
+    vector<const pair<const pair<string, long>, Counter>*> lns;
+    for (const auto& entry : lines)
+        lns.push_back(&entry);
+    sort(lns.begin(), lns.end(), [&](decltype(lns)::value_type a, decltype(lns)::value_type b) {
+        return byTicks(a->second, b->second);
+    });
+    for (auto entry : lns) {
+        out << (entry->first.first.empty() ? "<builtin>" : entry->first.first) << "\t"
+            << entry->first.second << "\t" << entry->second.count << "\t" << entry->second.ticks << "\n";
+    }
+}
+
+SamplingProfiler SamplingProfiler::instance;
+volatile sig_atomic_t SamplingProfiler::pending = 0;
+constexpr long SamplingProfiler::DEFAULT_INTERVAL;
+
+namespace {
+
+#ifdef USE_POSIX
+    void samplingHandler(int) {
+        SamplingProfiler::pending = 1;
+    }
+
+    bool setSamplingTimer(long interval) {
+        itimerval timer;
+        timer.it_interval.tv_sec = interval / 1000000;
+        timer.it_interval.tv_usec = interval % 1000000;
+        timer.it_value = timer.it_interval;
+        return setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+    }
+#endif
+
+    // Frame names may not contain the stack separator.
+    void appendFrame(string& out, const string& file, long line) {
+        if (!out.empty())
+            out += ';';
+        if (file.empty()) {
+            out += "<builtin>";
+        } else {
+            for (char ch : file)
+                out += (ch == ';') ? '_' : ch;
+        }
+        out += ':';
+        out += to_string(line);
+    }
+
+}
+
+SamplingProfiler::SamplingProfiler()
+    : enabled(false), filename(), samples(0), stacks() {}
+
+SamplingProfiler& SamplingProfiler::get() noexcept {
+    return instance;
+}
+
+bool SamplingProfiler::start(string file, long interval) {
+#ifdef USE_POSIX
+    static bool registered = false;
+    if (enabled)
+        stop();
+    struct sigaction action;
+    action.sa_handler = samplingHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    if (sigaction(SIGPROF, &action, nullptr) != 0)
+        return false;
+    filename = file;
+    enabled = true;
+    pending = 0;
+    if (!registered) {
+        // Make sure the results are written even if the program exits
+        // without returning from main.
+        registered = true;
+        atexit([]() { SamplingProfiler::get().stop(); });
+    }
+    if (!setSamplingTimer(interval)) {
+        enabled = false;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SamplingProfiler::stop() {
+    if (!enabled)
+        return;
+    enabled = false;
+#ifdef USE_POSIX
+    setSamplingTimer(0);
+#endif
+    pending = 0;
+    ofstream out { filename };
+    if (!out) {
+        cerr << "Could not write profile data to " << filename << endl;
+        return;
+    }
+    writeFolded(out);
+}
+
+void SamplingProfiler::reset() {
+    samples = 0;
+    stacks.clear();
+}
+
+void SamplingProfiler::sample(VMState& vm) {
+    pending = 0;
+    if (!enabled)
+        return;
+    // %trace is innermost-first, but folded stacks are outermost-first.
+    vector<const BacktraceFrame*> frames;
+    for (NodePtr<BacktraceFrame> node = vm.state.trace; node != nullptr; node = popNode(node))
+        frames.push_back(&node->get());
+    string stack;
+    for (auto iter = frames.rbegin(); iter != frames.rend(); ++iter)
+        appendFrame(stack, std::get<1>(**iter), std::get<0>(**iter));
+    appendFrame(stack, vm.state.file, vm.state.line);
+    ++stacks[stack];
+    ++samples;
+}
+
+unsigned long long SamplingProfiler::sampleCount() const noexcept {
+    return samples;
+}
+
+void SamplingProfiler::writeFolded(ostream& out) const {
+    vector<const pair<const string, unsigned long long>*> entries;
+    for (const auto& entry : stacks)
+        entries.push_back(&entry);
+    sort(entries.begin(), entries.end(), [](decltype(entries)::value_type a, decltype(entries)::value_type b) {
+        return a->first < b->first;
+    });
+    for (auto entry : entries)
+        out << entry->first << " " << entry->second << "\n";
+}
+
+AllocationProfiler::AllocationProfiler()
+    : enabled(false), filename(), source(nullptr), collections(0), sites(), siteIndex(),
+      lastSite(0) {}
+
+AllocationProfiler& AllocationProfiler::get() noexcept {
+    return instance;
+}
+
+unsigned int AllocationProfiler::findSite(const string& file, long line) {
+    if (lastSite < sites.size()) {
+        const Site& last = sites[lastSite];
+        if ((last.line == line) && (last.file == file))
+            return lastSite;
+    }
+    auto iter = siteIndex.find(make_pair(file, line));
+    if (iter == siteIndex.end()) {
+        iter = siteIndex.emplace(make_pair(file, line), sites.size()).first;
+        sites.push_back({ file, line, 0, 0 });
+    }
+    lastSite = iter->second;
+    return lastSite;
+}
+
+void AllocationProfiler::writeSnapshot(string header) {
+    ofstream out { filename, ios_base::app };
+    if (!out) {
+        cerr << "Could not write profile data to " << filename << endl;
+        return;
+    }
+    out << header << "\n";
+    writeReport(out);
+}
+
+void AllocationProfiler::start(string file, const IntState& state) {
+    static bool registered = false;
+    if (enabled)
+        stop();
+    {
+        ofstream out { file, ios_base::trunc };
+    }
+    filename = file;
+    source = &state;
+    enabled = true;
+    if (!registered) {
+        // Make sure the results are written even if the program exits
+        // without returning from main.
+        registered = true;
+        atexit([]() { AllocationProfiler::get().stop(); });
+    }
+}
+
+void AllocationProfiler::stop() {
+    if (!enabled)
+        return;
+    enabled = false;
+    source = nullptr;
+    writeSnapshot("# final collections=" + to_string(collections));
+}
+
+void AllocationProfiler::reset() {
+    collections = 0;
+    sites.clear();
+    siteIndex.clear();
+    lastSite = 0;
+    // The objects still remember sites from the old table.
+    Allocator::get().clearProfileSites();
+}
+
+void AllocationProfiler::recordAllocation(Object* obj) {
+    unsigned int site;
+    if (source == nullptr)
+        site = findSite("", 0);
+    else
+        site = findSite(source->file, source->line);
+    ++sites[site].total;
+    ++sites[site].live;
+    // The site is kept with the object itself, so that profiling does
+    // not allocate anything per object.
+    Allocator::setProfileSite(obj, site + 1);
+}
+
+void AllocationProfiler::recordFree(Object* obj) {
+    unsigned int site = Allocator::profileSite(obj);
+    if (site == 0)
+        return;
+    --sites[site - 1].live;
+}
+
+void AllocationProfiler::recordCollection(long freed) {
+    ++collections;
+    writeSnapshot("# collection " + to_string(collections) + " freed=" + to_string(freed));
+}
+
+unsigned long long AllocationProfiler::totalAt(const string& file, long line) const {
+    auto iter = siteIndex.find(make_pair(file, line));
+    if (iter == siteIndex.end())
+        return 0;
+    return sites[iter->second].total;
+}
+
+unsigned long long AllocationProfiler::liveAt(const string& file, long line) const {
+    auto iter = siteIndex.find(make_pair(file, line));
+    if (iter == siteIndex.end())
+        return 0;
+    return sites[iter->second].live;
+}
+
+void AllocationProfiler::writeReport(ostream& out) const {
+    vector<const Site*> entries;
+    for (const Site& site : sites)
+        entries.push_back(&site);
+    stable_sort(entries.begin(), entries.end(), [](const Site* a, const Site* b) {
+        return a->live > b->live;
+    });
+    out << "file\tline\tlive\ttotal\n";
+    for (const Site* site : entries) {
+        out << (site->file.empty() ? "<builtin>" : site->file) << "\t" << site->line << "\t"
+            << site->live << "\t" << site->total << "\n";
+    }
+}
@@ -0,0 +1,320 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "Instructions.hpp"
+#include <array>
+#include <csignal>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// \file
+///
+/// \brief Runtime profiling facilities for the Latitude VM.
+
+struct VMState;
+struct IntState;
+class Object;
+
+/// Reads a high-resolution, monotonically increasing tick counter. On
+/// x86 platforms, this is the processor's timestamp counter; on other
+/// platforms, it is a nanosecond clock.
+///
+/// \return the current tick count
+unsigned long long readTicks() noexcept;
+
+/// \brief An instruction-level profiler.
+///
+/// The instruction profiler is always compiled into the VM but is
+/// disabled by default, in which case it costs a single branch per
+/// instruction. When enabled, it records the number of times each
+/// opcode is executed and the number of ticks spent executing it,
+/// and it attributes the same information to the method and to the
+/// source line (according to `%%file` and `%%line`) which were
+/// current when each instruction began.
+class InstrProfiler {
+public:
+
+    /// \brief The accumulated cost of a group of instructions.
+    struct Counter {
+        unsigned long long count = 0;
+        unsigned long long ticks = 0;
+    };
+
+private:
+
+    struct MethodRecord {
+        TranslationUnitPtr unit;
+        long index;
+        std::string file;
+        long line;
+        Counter counter;
+    };
+
+    static InstrProfiler instance;
+
+    bool enabled;
+    std::string filename;
+    std::array<Counter, 256> opcodes;
+    std::unordered_map<const InstrSeq*, MethodRecord> methods;
+    std::map<std::pair<std::string, long>, Counter> lines;
+
+    // The state captured when the current instruction began
+    Instr currentInstr;
+    unsigned long long startTicks;
+    Counter* currentMethod;
+    Counter* currentLine;
+
+    // Caches, to avoid a map lookup on every instruction
+    const InstrSeq* lastSeq;
+    std::string lastFile;
+    long lastLine;
+
+    InstrProfiler();
+
+public:
+
+    /// Returns the instruction profiler singleton instance.
+    ///
+    /// \return the singleton instance
+    static InstrProfiler& get() noexcept;
+
+    /// \return whether the profiler is currently recording
+    bool isEnabled() const noexcept {
+        return enabled;
+    }
+
+    /// Enables the profiler. When the profiler is later stopped (or
+    /// when the program exits), the results are written to the given
+    /// file.
+    ///
+    /// \param file the name of the output file
+    void start(std::string file);
+
+    /// Disables the profiler and writes the accumulated results to the
+    /// output file, if the profiler was enabled. Calling this when the
+    /// profiler is not enabled has no effect.
+    void stop();
+
+    /// Clears all of the accumulated results.
+    void reset();
+
+    /// Records the beginning of an instruction. The VM's `%%cont`
+    /// register must be positioned at the instruction.
+    ///
+    /// \param vm the virtual machine state
+    /// \param instr the instruction about to be executed
+    void instructionBegin(VMState& vm, Instr instr);
+
+    /// Records the end of the instruction most recently passed to
+    /// #instructionBegin.
+    void instructionEnd() noexcept;
+
+    /// \param instr an opcode
+    /// \return the accumulated cost of the opcode
+    Counter opcodeCounter(Instr instr) const;
+
+    /// \param file a source file name
+    /// \param line a line number
+    /// \return the accumulated cost of the source line
+    Counter lineCounter(const std::string& file, long line) const;
+
+    /// Writes the accumulated results, in a tab-separated format, to
+    /// the given stream. The output consists of a header line and
+    /// then three sections, `[opcodes]`, `[methods]`, and `[lines]`,
+    /// each of which begins with a line of column names and is sorted
+    /// by ticks, in descending order.
+    ///
+    /// \param out the output stream
+    void writeReport(std::ostream& out) const;
+
+};
+
+/// \brief A statistical profiler which periodically samples the
+/// Latitude-level call stack.
+///
+/// While the sampling profiler is running, a timer signal fires at a
+/// fixed interval of CPU time. The signal handler only sets a flag;
+/// the VM checks the flag between instructions and, at that safepoint,
+/// records the `%%trace` stack together with the current `%%file` and
+/// `%%line`. The results are written in the "folded stacks" format
+/// understood by flame graph tools: one line per distinct stack, with
+/// frames separated by semicolons from outermost to innermost,
+/// followed by a space and the number of samples.
+class SamplingProfiler {
+private:
+
+    static SamplingProfiler instance;
+
+    bool enabled;
+    std::string filename;
+    unsigned long long samples;
+    std::unordered_map<std::string, unsigned long long> stacks;
+
+    SamplingProfiler();
+
+public:
+
+    /// Set asynchronously, by the timer signal, when a sample should
+    /// be taken at the next safepoint.
+    static volatile std::sig_atomic_t pending;
+
+    /// The default sampling interval, in microseconds.
+    static constexpr long DEFAULT_INTERVAL = 1000;
+
+    /// Returns the sampling profiler singleton instance.
+    ///
+    /// \return the singleton instance
+    static SamplingProfiler& get() noexcept;
+
+    /// \return whether the profiler is currently sampling
+    bool isEnabled() const noexcept {
+        return enabled;
+    }
+
+    /// Starts sampling. If the profiler is already running, it is
+    /// stopped first, writing out its results. When the profiler is
+    /// later stopped (or when the program exits), the results are
+    /// written to the given file.
+    ///
+    /// \param file the name of the output file
+    /// \param interval the sampling interval, in microseconds
+    /// \return false if sampling is not supported on this platform
+    bool start(std::string file, long interval = DEFAULT_INTERVAL);
+
+    /// Stops sampling and writes the accumulated results to the output
+    /// file, if the profiler was running. Calling this when the
+    /// profiler is not running has no effect.
+    void stop();
+
+    /// Clears all of the accumulated samples.
+    void reset();
+
+    /// Records a single sample of the VM's current call stack and
+    /// clears the #pending flag.
+    ///
+    /// \param vm the virtual machine state
+    void sample(VMState& vm);
+
+    /// \return the number of samples recorded since the last reset
+    unsigned long long sampleCount() const noexcept;
+
+    /// Writes the accumulated samples, as folded stacks, to the given
+    /// stream.
+    ///
+    /// \param out the output stream
+    void writeFolded(std::ostream& out) const;
+
+};
+
+/// \brief A profiler which attributes object allocations to the
+/// source locations responsible for them.
+///
+/// While the allocation profiler is running, the garbage collector
+/// reports every object it allocates and frees. Each allocation is
+/// charged to the `%%file` and `%%line` of the interpreter state that
+/// was current at the time, and the profiler keeps, for each such
+/// site, the total number of objects allocated and the number which
+/// are still alive. The site of each object is recorded in its
+/// allocator slot, so no memory is allocated per object while
+/// profiling. A snapshot of the table is appended to the output
+/// file after every garbage collection and once more when the
+/// profiler stops.
+class AllocationProfiler {
+private:
+
+    struct Site {
+        std::string file;
+        long line;
+        unsigned long long total;
+        unsigned long long live;
+    };
+
+    static AllocationProfiler instance;
+
+    bool enabled;
+    std::string filename;
+    const IntState* source;
+    unsigned long collections;
+    std::vector<Site> sites;
+    std::map<std::pair<std::string, long>, unsigned int> siteIndex;
+
+    // Cache, to avoid a map lookup on every allocation
+    unsigned int lastSite;
+
+    AllocationProfiler();
+
+    unsigned int findSite(const std::string& file, long line);
+    void writeSnapshot(std::string header);
+
+public:
+
+    /// Returns the allocation profiler singleton instance.
+    ///
+    /// \return the singleton instance
+    static AllocationProfiler& get() noexcept;
+
+    /// \return whether the profiler is currently recording
+    bool isEnabled() const noexcept {
+        return enabled;
+    }
+
+    /// Starts recording allocations, truncating the output file. If
+    /// the profiler is already running, it is stopped first.
+    ///
+    /// \param file the name of the output file
+    /// \param state the interpreter state whose `%%file` and `%%line`
+    /// identify the current allocation site
+    void start(std::string file, const IntState& state);
+
+    /// Stops recording allocations and appends a final snapshot to the
+    /// output file, if the profiler was running. Calling this when the
+    /// profiler is not running has no effect.
+    void stop();
+
+    /// Clears all of the accumulated results.
+    void reset();
+
+    /// Charges a newly allocated object to the current site.
+    ///
+    /// \param obj the object
+    void recordAllocation(Object* obj);
+
+    /// Records that an object has been freed. Objects which were not
+    /// allocated while the profiler was running are ignored.
+    ///
+    /// \param obj the object
+    void recordFree(Object* obj);
+
+    /// Records that the garbage collector has just run, appending a
+    /// snapshot of the table to the output file.
+    ///
+    /// \param freed the number of objects freed by the collection
+    void recordCollection(long freed);
+
+    /// \param file a source file name
+    /// \param line a line number
+    /// \return the number of objects allocated at the site
+    unsigned long long totalAt(const std::string& file, long line) const;
+
+    /// \param file a source file name
+    /// \param line a line number
+    /// \return the number of objects allocated at the site which
+    /// have not yet been freed
+    unsigned long long liveAt(const std::string& file, long line) const;
+
+    /// Writes the allocation table, in a tab-separated format, to the
+    /// given stream. The table begins with a line of column names and
+    /// is sorted by the number of live objects, in descending order.
+    ///
+    /// \param out the output stream
+    void writeReport(std::ostream& out) const;
+
+};
+
+#endif // PROFILER_HPP
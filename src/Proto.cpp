@@ -9,6 +9,7 @@
 #include "Macro.hpp"
 #include "Allocator.hpp"
 #include <tuple>
+#include <cstring>
 
 using namespace std;
 
@@ -91,6 +92,269 @@ bool PtrCompare::operator()(const ObjectPtr& a, const ObjectPtr& b) {
     return a.get() < b.get();
 }
 
+ArrayStore::ArrayStore() noexcept : impl() {}
+
+ArrayStore::ArrayStore(const ArrayStore& other) noexcept : impl(other.impl) {}
+
+ArrayStore::ArrayStore(ArrayStore&& other) noexcept : impl(std::move(other.impl)) {}
+
+ArrayStore& ArrayStore::operator=(const ArrayStore& other) noexcept {
+    impl = other.impl;
+    return *this;
+}
+
+ArrayStore& ArrayStore::operator=(ArrayStore&& other) noexcept {
+    impl = std::move(other.impl);
+    return *this;
+}
+
+deque<ObjectPtr>& ArrayStore::elements() {
+    if (!impl)
+        impl = make_shared< deque<ObjectPtr> >();
+    else if (impl.use_count() > 1)
+        impl = make_shared< deque<ObjectPtr> >(*impl);
+    return *impl;
+}
+
+const deque<ObjectPtr>& ArrayStore::elements() const noexcept {
+    static const deque<ObjectPtr> empty {};
+    return impl ? *impl : empty;
+}
+
+size_t ArrayStore::size() const noexcept {
+    return impl ? impl->size() : 0;
+}
+
+bool ArrayStore::operator==(const ArrayStore& other) const {
+    return (impl == other.impl) || (elements() == other.elements());
+}
+
+namespace {
+
+    constexpr long EMPTY_BUCKET = -1;
+
+    size_t hashKey(const ObjectPtr& key) {
+        Prim& prim = key->prim();
+        if (auto str = boost::get<string>(&prim))
+            return hash<string>()(*str);
+        if (auto num = boost::get<Number>(&prim))
+            return num->hash();
+        if (auto sym = boost::get<Symbolic>(&prim))
+            return hash<Symbolic>()(*sym);
+        return hash<Object*>()(key.get());
+    }
+
+    bool keyEquals(const ObjectPtr& a, const ObjectPtr& b) {
+        if (a == b)
+            return true;
+        Prim& prim0 = a->prim();
+        Prim& prim1 = b->prim();
+        if (prim0.which() != prim1.which())
+            return false;
+        if (auto str = boost::get<string>(&prim0))
+            return *str == boost::get<string>(prim1);
+        if (auto num = boost::get<Number>(&prim0))
+            return *num == boost::get<Number>(prim1);
+        if (auto sym = boost::get<Symbolic>(&prim0))
+            return *sym == boost::get<Symbolic>(prim1);
+        return false;
+    }
+
+}
+
+DictStore::DictStore() noexcept : impl() {}
+
+DictStore::DictStore(const DictStore& other) noexcept : impl(other.impl) {}
+
+DictStore::DictStore(DictStore&& other) noexcept : impl(std::move(other.impl)) {}
+
+DictStore& DictStore::operator=(const DictStore& other) noexcept {
+    impl = other.impl;
+    return *this;
+}
+
+DictStore& DictStore::operator=(DictStore&& other) noexcept {
+    impl = std::move(other.impl);
+    return *this;
+}
+
+template <typename Eq>
+long DictStore::find(size_t hash, Eq eq) const {
+    if (!impl)
+        return EMPTY_BUCKET;
+    size_t mask = impl->index.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        long pos = impl->index[i];
+        if (pos == EMPTY_BUCKET)
+            return EMPTY_BUCKET;
+        const Entry& entry = impl->entries[pos];
+        if ((entry.key != nullptr) && (entry.hash == hash) && eq(entry.key))
+            return pos;
+    }
+}
+
+void DictStore::unshare() {
+    if (!impl)
+        impl = make_shared<Table>(Table { {}, {}, 0 });
+    else if (impl.use_count() > 1)
+        impl = make_shared<Table>(*impl);
+}
+
+void DictStore::rehash(size_t count) {
+    // Drop any removed entries, then rebuild the index with enough
+    // buckets to keep the load factor below two thirds.
+    vector<Entry> entries;
+    entries.reserve(count);
+    for (Entry& entry : impl->entries) {
+        if (entry.key != nullptr)
+            entries.push_back(std::move(entry));
+    }
+    size_t capacity = 8;
+    while (capacity * 2 < count * 3)
+        capacity *= 2;
+    impl->entries = std::move(entries);
+    impl->index.assign(capacity, EMPTY_BUCKET);
+    size_t mask = capacity - 1;
+    for (size_t pos = 0; pos < impl->entries.size(); pos++) {
+        size_t i = impl->entries[pos].hash & mask;
+        while (impl->index[i] != EMPTY_BUCKET)
+            i = (i + 1) & mask;
+        impl->index[i] = (long)pos;
+    }
+}
+
+ObjectPtr DictStore::get(ObjectPtr key) const {
+    long pos = find(hashKey(key), [&key](const ObjectPtr& key1) { return keyEquals(key, key1); });
+    return (pos == EMPTY_BUCKET) ? nullptr : impl->entries[pos].value;
+}
+
+ObjectPtr DictStore::get(Symbolic key) const {
+    long pos = find(hash<Symbolic>()(key), [&key](const ObjectPtr& key1) {
+            auto sym = boost::get<Symbolic>(&key1->prim());
+            return (sym != nullptr) && (*sym == key);
+        });
+    return (pos == EMPTY_BUCKET) ? nullptr : impl->entries[pos].value;
+}
+
+void DictStore::put(ObjectPtr key, ObjectPtr value) {
+    size_t hash = hashKey(key);
+    long pos = find(hash, [&key](const ObjectPtr& key1) { return keyEquals(key, key1); });
+    if ((pos != EMPTY_BUCKET) && (impl->entries[pos].value == value))
+        return;
+    unshare();
+    if (pos != EMPTY_BUCKET) {
+        impl->entries[pos].value = value;
+        return;
+    }
+    if ((impl->entries.size() + 1) * 3 > impl->index.size() * 2)
+        rehash(impl->live * 2 + 1);
+    impl->entries.push_back({ key, value, hash });
+    size_t mask = impl->index.size() - 1;
+    size_t i = hash & mask;
+    while (impl->index[i] != EMPTY_BUCKET)
+        i = (i + 1) & mask;
+    impl->index[i] = (long)(impl->entries.size() - 1);
+    impl->live++;
+}
+
+bool DictStore::remove(ObjectPtr key) {
+    long pos = find(hashKey(key), [&key](const ObjectPtr& key1) { return keyEquals(key, key1); });
+    if (pos == EMPTY_BUCKET)
+        return false;
+    unshare();
+    if (--impl->live == 0) {
+        impl.reset();
+    } else {
+        // Leave the entry in place so that probing continues past it.
+        impl->entries[pos].key = nullptr;
+        impl->entries[pos].value = nullptr;
+    }
+    return true;
+}
+
+size_t DictStore::size() const noexcept {
+    return impl ? impl->live : 0;
+}
+
+vector<ObjectPtr> DictStore::keys() const {
+    vector<ObjectPtr> result;
+    result.reserve(size());
+    forEach([&result](const ObjectPtr& key, const ObjectPtr&) { result.push_back(key); });
+    return result;
+}
+
+void DictStore::forEach(const function<void(const ObjectPtr&, const ObjectPtr&)>& func) const {
+    if (!impl)
+        return;
+    for (const Entry& entry : impl->entries) {
+        if (entry.key != nullptr)
+            func(entry.key, entry.value);
+    }
+}
+
+bool DictStore::operator==(const DictStore& other) const {
+    if (impl == other.impl)
+        return true;
+    if (size() != other.size())
+        return false;
+    bool result = true;
+    forEach([&other, &result](const ObjectPtr& key, const ObjectPtr& value) {
+            if (result && (other.get(key) != value))
+                result = false;
+        });
+    return result;
+}
+
+ByteBuffer::ByteBuffer() noexcept : impl(), start(0), length(0) {}
+
+ByteBuffer::ByteBuffer(string bytes)
+    : impl(make_shared<const string>(std::move(bytes))), start(0), length(impl->size()) {}
+
+size_t ByteBuffer::size() const noexcept {
+    return length;
+}
+
+const char* ByteBuffer::data() const noexcept {
+    return impl ? impl->data() + start : "";
+}
+
+unsigned char ByteBuffer::operator[](size_t index) const noexcept {
+    return static_cast<unsigned char>(data()[index]);
+}
+
+ByteBuffer ByteBuffer::slice(size_t from, size_t to) const {
+    ByteBuffer result;
+    to = min(to, length);
+    if (from < to) {
+        result.impl = impl;
+        result.start = start + from;
+        result.length = to - from;
+    }
+    return result;
+}
+
+uint64_t ByteBuffer::decode(size_t index, size_t width, bool bigEndian) const noexcept {
+    uint64_t result = 0;
+    for (size_t i = 0; i < width; i++) {
+        size_t pos = bigEndian ? index + i : index + width - i - 1;
+        result = (result << 8) | (*this)[pos];
+    }
+    return result;
+}
+
+string ByteBuffer::toString() const {
+    return string(data(), length);
+}
+
+bool ByteBuffer::operator==(const ByteBuffer& other) const noexcept {
+    return (length == other.length) && (memcmp(data(), other.data(), length) == 0);
+}
+
+bool ByteBuffer::operator<(const ByteBuffer& other) const noexcept {
+    int cmp = memcmp(data(), other.data(), min(length, other.length));
+    return (cmp < 0) || ((cmp == 0) && (length < other.length));
+}
+
 Slot::Slot(ObjectPtr ptr) noexcept : Slot(ptr, Protection::NO_PROTECTION) {}
 
 Slot::Slot(ObjectPtr ptr, Protection protect) noexcept : obj(ptr), protection(protect) {}
@@ -10,11 +10,16 @@
 #include "Number.hpp"
 #include "Instructions.hpp"
 #include "Protection.hpp"
+#include "Unicode.hpp"
+#include "Random.hpp"
+#include <cstdint>
 #include <list>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include <string>
 #include <boost/variant.hpp>
 #include <boost/blank.hpp>
@@ -140,11 +145,285 @@ struct PtrCompare {
 
 };
 
+/// \brief The native element storage of an array object.
+///
+/// Arrays keep their elements in a double-ended queue in the `prim`
+/// field, giving constant time access at either end and by index.
+/// Copying an ArrayStore is a constant time operation: the copies
+/// share a single queue until one of them is modified, at which point
+/// the modified copy takes a private copy of the queue (but not of the
+/// objects to which it points). A cloned array therefore behaves as
+/// though it never shares storage with the original. The queue itself
+/// is only allocated once an element is added.
+class ArrayStore {
+private:
+    std::shared_ptr< std::deque<ObjectPtr> > impl;
+public:
+
+    /// Constructs an empty array store.
+    ArrayStore() noexcept;
+
+    /// Constructs a copy of the array store, containing the same
+    /// object pointers. The queue is shared until either store is
+    /// modified.
+    ///
+    /// \param other the store to copy
+    ArrayStore(const ArrayStore& other) noexcept;
+
+    /// Constructs an array store by taking the elements from another
+    /// store, which is left empty.
+    ///
+    /// \param other the store to move from
+    ArrayStore(ArrayStore&& other) noexcept;
+
+    /// Replaces the contents of the store with a copy of another
+    /// store's elements. The queue is shared until either store is
+    /// modified.
+    ///
+    /// \param other the store to copy
+    /// \return the store
+    ArrayStore& operator=(const ArrayStore& other) noexcept;
+
+    /// Replaces the contents of the store with the elements of
+    /// another store, which is left empty.
+    ///
+    /// \param other the store to move from
+    /// \return the store
+    ArrayStore& operator=(ArrayStore&& other) noexcept;
+
+    /// Returns the elements of the array for modification, allocating
+    /// storage for them if necessary. If the storage is shared with
+    /// another store, it is copied first. Code which only reads the
+    /// elements should use the const overload, which never copies.
+    ///
+    /// \return the elements
+    std::deque<ObjectPtr>& elements();
+
+    /// Returns the elements of the array.
+    ///
+    /// \return the elements
+    const std::deque<ObjectPtr>& elements() const noexcept;
+
+    /// Returns the number of elements in the array.
+    ///
+    /// \return the size
+    size_t size() const noexcept;
+
+    /// Returns whether the two stores contain the same object
+    /// pointers, in the same order.
+    ///
+    /// \param other the store to compare to
+    /// \return whether the stores are equal
+    bool operator==(const ArrayStore& other) const;
+
+};
+
+/// \brief The native storage of a dictionary.
+///
+/// Dictionaries keep their entries in an open-addressing hash table
+/// in the `prim` field. A key whose primitive field is a string, a
+/// number, or a symbol is compared to other keys by value; any other
+/// key is compared by identity. Entries are kept in the order in
+/// which they were first added. As with ArrayStore, copies of a
+/// DictStore share a single table until one of them is modified, and
+/// the table itself is only allocated once an entry is added.
+class DictStore {
+private:
+
+    struct Entry {
+        ObjectPtr key;
+        ObjectPtr value;
+        std::size_t hash;
+    };
+
+    // The entries are stored densely in insertion order, and the
+    // index maps hash buckets to positions in the entry list. A
+    // removed entry keeps its position, with a null key, until the
+    // next rehash.
+    struct Table {
+        std::vector<Entry> entries;
+        std::vector<long> index;
+        std::size_t live;
+    };
+
+    std::shared_ptr<Table> impl;
+
+    template <typename Eq>
+    long find(std::size_t hash, Eq eq) const;
+
+    void unshare();
+
+    void rehash(std::size_t capacity);
+
+public:
+
+    /// Constructs an empty dictionary store.
+    DictStore() noexcept;
+
+    /// Constructs a copy of the dictionary store, containing the same
+    /// object pointers. The table is shared until either store is
+    /// modified.
+    ///
+    /// \param other the store to copy
+    DictStore(const DictStore& other) noexcept;
+
+    /// Constructs a dictionary store by taking the entries from
+    /// another store, which is left empty.
+    ///
+    /// \param other the store to move from
+    DictStore(DictStore&& other) noexcept;
+
+    /// Replaces the contents of the store with a copy of another
+    /// store's entries. The table is shared until either store is
+    /// modified.
+    ///
+    /// \param other the store to copy
+    /// \return the store
+    DictStore& operator=(const DictStore& other) noexcept;
+
+    /// Replaces the contents of the store with the entries of another
+    /// store, which is left empty.
+    ///
+    /// \param other the store to move from
+    /// \return the store
+    DictStore& operator=(DictStore&& other) noexcept;
+
+    /// Looks up the value associated with a key.
+    ///
+    /// \param key the key
+    /// \return the value, or nullptr if the key is not present
+    ObjectPtr get(ObjectPtr key) const;
+
+    /// Looks up the value associated with a symbol key, without
+    /// requiring a symbol object to be constructed.
+    ///
+    /// \param key the key
+    /// \return the value, or nullptr if the key is not present
+    ObjectPtr get(Symbolic key) const;
+
+    /// Associates a value with a key, replacing any value which was
+    /// already associated with an equal key.
+    ///
+    /// \param key the key
+    /// \param value the value
+    void put(ObjectPtr key, ObjectPtr value);
+
+    /// Removes the entry associated with a key, if there is one.
+    ///
+    /// \param key the key
+    /// \return whether an entry was removed
+    bool remove(ObjectPtr key);
+
+    /// Returns the number of entries in the dictionary.
+    ///
+    /// \return the size
+    std::size_t size() const noexcept;
+
+    /// Returns the keys of the dictionary, in insertion order.
+    ///
+    /// \return the keys
+    std::vector<ObjectPtr> keys() const;
+
+    /// Calls a function for each entry of the dictionary, in
+    /// insertion order. The function must not modify the store.
+    ///
+    /// \param func a function accepting a key and a value
+    void forEach(const std::function<void(const ObjectPtr&, const ObjectPtr&)>& func) const;
+
+    /// Returns whether the two stores contain the same keys,
+    /// associated with the same object pointers.
+    ///
+    /// \param other the store to compare to
+    /// \return whether the stores are equal
+    bool operator==(const DictStore& other) const;
+
+};
+
+/// \brief The native storage of a byte buffer.
+///
+/// A byte buffer is an immutable sequence of raw bytes, which is
+/// stored as a view into a shared block of memory. Copying a
+/// ByteBuffer or taking a slice of it never copies the bytes
+/// themselves, so a large buffer read from a stream can be cut into
+/// pieces in constant time. The block is freed once no buffer refers
+/// to any part of it.
+class ByteBuffer {
+private:
+    std::shared_ptr<const std::string> impl;
+    std::size_t start;
+    std::size_t length;
+public:
+
+    /// Constructs an empty byte buffer.
+    ByteBuffer() noexcept;
+
+    /// Constructs a byte buffer containing the given bytes.
+    ///
+    /// \param bytes the bytes
+    explicit ByteBuffer(std::string bytes);
+
+    /// Returns the number of bytes in the buffer.
+    ///
+    /// \return the size
+    std::size_t size() const noexcept;
+
+    /// Returns a pointer to the first byte of the buffer. The bytes
+    /// are not null-terminated.
+    ///
+    /// \return the bytes
+    const char* data() const noexcept;
+
+    /// Returns the byte at the given position, which must be less
+    /// than the size of the buffer.
+    ///
+    /// \param index the position
+    /// \return the byte
+    unsigned char operator[](std::size_t index) const noexcept;
+
+    /// Returns a buffer viewing part of this one, without copying any
+    /// bytes. The range is clamped to the bounds of the buffer.
+    ///
+    /// \param from the position of the first byte
+    /// \param to the position after the last byte
+    /// \return the slice
+    ByteBuffer slice(std::size_t from, std::size_t to) const;
+
+    /// Decodes an unsigned integer from consecutive bytes of the
+    /// buffer. The range must lie within the buffer, and the width
+    /// must be at most eight bytes.
+    ///
+    /// \param index the position of the first byte
+    /// \param width the number of bytes
+    /// \param bigEndian whether the most significant byte comes first
+    /// \return the integer
+    std::uint64_t decode(std::size_t index, std::size_t width, bool bigEndian) const noexcept;
+
+    /// Returns a copy of the bytes of the buffer.
+    ///
+    /// \return a string containing the bytes
+    std::string toString() const;
+
+    /// Returns whether the two buffers contain the same bytes.
+    ///
+    /// \param other the buffer to compare to
+    /// \return whether the buffers are equal
+    bool operator==(const ByteBuffer& other) const noexcept;
+
+    /// Compares the bytes of the two buffers lexicographically, as
+    /// unsigned values.
+    ///
+    /// \param other the buffer to compare to
+    /// \return whether this buffer comes first
+    bool operator<(const ByteBuffer& other) const noexcept;
+
+};
+
 /// \brief A primitive field, which can be either empty or an element
 /// of any number of types.
 using Prim = boost::variant<boost::blank, Number, std::string,
                             StreamPtr, Symbolic, ProcessPtr,
-                            Method, StatePtr>;
+                            Method, StatePtr, ArrayStore, DictStore,
+                            ByteBuffer, RandomGenerator>;
 
 /// A Slot is either empty (INH) or has contents (PTR).
 ///
@@ -285,7 +564,9 @@ public:
 
     /// Sets the `prim` field of the object to the specified value,
     /// which must be assignable to the type Prim. The old value of
-    /// the `prim` field is returned.
+    /// the `prim` field is returned. Any cached index of a string in
+    /// the old field is discarded. A string in the `prim` field
+    /// should only ever be changed through this method.
     ///
     /// \param prim0 the new value
     /// \return the old value
@@ -302,6 +583,7 @@ void Object::protectAll(Protection p, T key, Ts... keys) {
 
 template <typename T>
 Prim Object::prim(const T& prim0) {
+    Utf8IndexCache::get().forget(this);
     Prim old = primitive;
     primitive = prim0;
     return old;
@@ -0,0 +1,80 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+
+#include "Random.hpp"
+
+namespace {
+
+    std::uint64_t rotateLeft(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+}
+
+RandomGenerator::RandomGenerator(std::uint64_t seed) noexcept {
+    // SplitMix64, as recommended by the authors of xoshiro for
+    // initializing its state. It never produces four zero words.
+    for (std::uint64_t& word : state) {
+        seed += 0x9E3779B97F4A7C15ULL;
+        std::uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        word = z ^ (z >> 31);
+    }
+}
+
+std::uint64_t RandomGenerator::next() noexcept {
+    std::uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+    std::uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotateLeft(state[3], 45);
+    return result;
+}
+
+std::uint64_t RandomGenerator::nextBelow(std::uint64_t bound) noexcept {
+#ifdef __SIZEOF_INT128__
+    // Lemire's method: the high word of the 128-bit product is the
+    // result, and only products whose low word falls in the first
+    // (2^64 mod bound) values are biased. The division computing
+    // that threshold is needed only when the low word is smaller
+    // than the bound, which for small bounds is almost never.
+    unsigned __int128 product = static_cast<unsigned __int128>(next()) * bound;
+    std::uint64_t low = static_cast<std::uint64_t>(product);
+    if (low < bound) {
+        std::uint64_t threshold = -bound % bound;
+        while (low < threshold) {
+            product = static_cast<unsigned __int128>(next()) * bound;
+            low = static_cast<std::uint64_t>(product);
+        }
+    }
+    return static_cast<std::uint64_t>(product >> 64);
+#else
+    // Without a 128-bit type, values from the incomplete final copy
+    // of the range at the bottom of the 64-bit space are rejected,
+    // so every result is equally likely.
+    std::uint64_t threshold = -bound % bound;
+    while (true) {
+        std::uint64_t value = next();
+        if (value >= threshold)
+            return value % bound;
+    }
+#endif
+}
+
+double RandomGenerator::nextDouble() noexcept {
+    // The top 53 bits fill the mantissa of a double exactly.
+    return (next() >> 11) * (1.0 / (1ULL << 53));
+}
+
+bool RandomGenerator::operator==(const RandomGenerator& other) const noexcept {
+    for (int i = 0; i < 4; i++) {
+        if (state[i] != other.state[i])
+            return false;
+    }
+    return true;
+}
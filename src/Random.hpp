@@ -0,0 +1,57 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cstdint>
+
+/// \file
+///
+/// \brief The RandomGenerator class, a fast pseudorandom number
+/// generator.
+
+/// A RandomGenerator is a xoshiro256** pseudorandom number
+/// generator. Its entire state is four 64-bit words, so generators
+/// are cheap to copy, and a copy produces the same sequence of values
+/// as the original from that point on. The generator is not suitable
+/// for cryptographic purposes.
+class RandomGenerator {
+private:
+    std::uint64_t state[4];
+public:
+
+    /// Constructs a generator from a seed. The seed is expanded into
+    /// the full state with SplitMix64, so similar seeds still produce
+    /// unrelated sequences.
+    ///
+    /// \param seed the seed
+    explicit RandomGenerator(std::uint64_t seed = 0) noexcept;
+
+    /// Returns the next 64 bits from the generator.
+    ///
+    /// \return the next value
+    std::uint64_t next() noexcept;
+
+    /// Returns the next value from the generator, reduced without
+    /// bias to a number less than \p bound, which must be positive.
+    ///
+    /// \param bound the exclusive upper bound
+    /// \return the next value
+    std::uint64_t nextBelow(std::uint64_t bound) noexcept;
+
+    /// Returns the next value from the generator as a floating point
+    /// number uniformly distributed in the interval [0, 1).
+    ///
+    /// \return the next value
+    double nextDouble() noexcept;
+
+    /// Returns whether the two generators are in the same state.
+    ///
+    /// \param other the generator to compare to
+    /// \return whether the generators are equal
+    bool operator==(const RandomGenerator& other) const noexcept;
+
+};
+
+#endif // RANDOM_HPP
@@ -9,6 +9,7 @@ extern "C" {
     extern int hash_parens;
 }
 #include "Reader.hpp"
+#include "Arena.hpp"
 #include "Symbol.hpp"
 #include "Standard.hpp"
 #include "Garnish.hpp"
@@ -32,24 +33,53 @@ extern "C" {
 
 using namespace std;
 
-PtrToList currentLine;
-
-void ExprDeleter::operator()(Expr* x) const {
-    cleanupE(x);
+// The arena holding the Expr, List, and Stmt nodes of the top-level
+// statement currently being parsed. Names in the Expr nodes are
+// allocated by the scanner, not the arena, so they are freed when the
+// arena is released.
+struct ParseArena {
+    Arena memory;
+    vector<Expr*> exprs;
+    void release() noexcept;
+};
+
+void ParseArena::release() noexcept {
+    for (Expr* expr : exprs) {
+        if (expr->name != nullptr)
+            free(expr->name);
+    }
+    exprs.clear();
+    memory.release();
 }
 
-void ExprDeleter::operator()(List* x) const {
-    cleanupL(x);
-}
+// The operator table, statement callback, and arena of the parse
+// currently in progress, used by emitLine().
+const OperatorTable* currentTable = nullptr;
+const StmtCallback* currentCallback = nullptr;
+ParseArena* currentArena = nullptr;
 
 extern "C" {
-    void setCurrentLine(List* stmt) {
-        currentLine.reset(stmt);
+
+    Expr* allocExpr() {
+        if (currentArena == nullptr)
+            return new Expr();
+        void* mem = currentArena->memory.allocate(sizeof(Expr), alignof(Expr));
+        Expr* expr = new (mem) Expr();
+        currentArena->exprs.push_back(expr);
+        return expr;
+    }
+
+    List* allocList() {
+        if (currentArena == nullptr)
+            return new List();
+        void* mem = currentArena->memory.allocate(sizeof(List), alignof(List));
+        return new (mem) List();
+    }
+
+    bool inParseArena() {
+        return (currentArena != nullptr);
     }
-}
 
-PtrToList getCurrentLine() {
-    return std::move(currentLine);
 }
 
 unique_ptr<Stmt> translateStmt(const OperatorTable& table, Expr*& expr, bool held);
@@ -91,11 +121,8 @@ unique_ptr<Stmt> translateStmt(const OperatorTable& table, Expr*& expr, bool hel
         else
             return unique_ptr<Stmt>(new StmtZeroDispatch(line, name[2], name[0], name + 3));
     } else if (expr->isMethod) {
-        auto contents0 = translateList(table, expr->args, held);
-        list< shared_ptr<Stmt> > contents1( contents0.size() );
-        transform(contents0.begin(), contents0.end(), contents1.begin(),
-                  [](auto& cc) { return move(cc); });
-        return unique_ptr<Stmt>(new StmtMethod(line, contents1));
+        auto contents = translateList(table, expr->args, held);
+        return unique_ptr<Stmt>(new StmtMethod(line, contents));
     } else if (expr->isComplex) {
         return unique_ptr<Stmt>(new StmtComplex(line, expr->number, expr->number1));
     } else if (expr->equals) {
@@ -149,22 +176,24 @@ list< unique_ptr<Stmt> > translateList(const OperatorTable& table, List* lst, bo
     }
 }
 
-list< unique_ptr<Stmt> > translateCurrentLine(const OperatorTable& table) {
-    if (currentLine)
-        return translateList(table, currentLine.get(), false);
-    else
-        return list< unique_ptr<Stmt> >();
-}
-
-void clearCurrentLine() noexcept {
-    currentLine.reset();
+extern "C" {
+    void emitLine(Expr* stmt) {
+        assert((currentTable != nullptr) && (currentCallback != nullptr));
+        assert(currentArena != nullptr);
+        {
+            auto result = translateStmt(*currentTable, stmt, false);
+            (*currentCallback)(*result);
+        }
+        // Nothing from this statement is referenced past this point,
+        // not even by the parser's own stacks.
+        currentArena->release();
+    }
 }
 
-std::list< std::unique_ptr<Stmt> > parse(const OperatorTable& table,
-                                         std::string filename,
-                                         std::string str) {
-    const char* buffer = str.c_str();
-    auto curr = yy_scan_string(buffer);
+// Runs the parser over the scanner's current buffer.
+void runParser(const OperatorTable& table,
+               const std::string& filename,
+               const StmtCallback& callback) {
     auto& g_filename = ::filename;
     line_num = 1;
     if (g_filename != nullptr)
@@ -174,24 +203,74 @@ std::list< std::unique_ptr<Stmt> > parse(const OperatorTable& table,
     strcpy(g_filename, filename.c_str());
     comments = 0;
     hash_parens = 0;
+    ParseArena arena;
+    currentTable = &table;
+    currentCallback = &callback;
+    currentArena = &arena;
+    BOOST_SCOPE_EXIT(&arena) {
+        currentTable = nullptr;
+        currentCallback = nullptr;
+        currentArena = nullptr;
+        arena.release();
+    } BOOST_SCOPE_EXIT_END;
     yyparse();
-    yy_delete_buffer(curr);
-    auto result = translateCurrentLine(table);
-    clearCurrentLine();
-    return result;
+}
+
+void parse(const OperatorTable& table,
+           std::string filename,
+           std::string str,
+           const StmtCallback& callback) {
+    auto curr = yy_scan_string(str.c_str());
+    BOOST_SCOPE_EXIT(curr) {
+        yy_delete_buffer(curr);
+    } BOOST_SCOPE_EXIT_END;
+    runParser(table, filename, callback);
+}
+
+void parseFile(const OperatorTable& table,
+               std::string filename,
+               const StmtCallback& callback) {
+    FILE* file = fopen(filename.c_str(), "r");
+    if (file == nullptr)
+        throw ios_base::failure("Could not open file " + filename);
+    BOOST_SCOPE_EXIT(file) {
+        fclose(file);
+    } BOOST_SCOPE_EXIT_END;
+    auto curr = yy_create_buffer(file, YY_BUF_SIZE);
+    BOOST_SCOPE_EXIT(curr) {
+        yy_delete_buffer(curr);
+    } BOOST_SCOPE_EXIT_END;
+    yy_switch_to_buffer(curr);
+    runParser(table, filename, callback);
+}
+
+// Translates a source file one top-level statement at a time, so that
+// only a single statement's AST is alive at once. Methods are added
+// to the unit as they are encountered, and the top-level sequence is
+// returned.
+InstrSeq translateFile(TranslationUnit& unit,
+                       string fname,
+                       const OperatorTable& table) {
+    InstrSeq toplevel;
+    (makeAssemblerLine(Instr::LOCFN, fname)).appendOnto(toplevel);
+    parseFile(table, fname, [&unit, &toplevel, &fname](Stmt& stmt) {
+        stmt.propogateFileName(fname);
+        stmt.translate(unit, toplevel);
+    });
+    (makeAssemblerLine(Instr::RET)).appendOnto(toplevel);
+    return toplevel;
 }
 
 bool eval(VMState& vm,
           const OperatorTable& table,
           string str) {
     try {
-        auto result = parse(table, "(eval)", str);
-        if (!result.empty()) {
-            TranslationUnitPtr unit = make_shared<TranslationUnit>();
-            InstrSeq toplevel;
-            for (auto& stmt : result) {
-                stmt->translate(*unit, toplevel);
-            }
+        TranslationUnitPtr unit = make_shared<TranslationUnit>();
+        InstrSeq toplevel;
+        parse(table, "(eval)", str, [&unit, &toplevel](Stmt& stmt) {
+            stmt.translate(*unit, toplevel);
+        });
+        if (!toplevel.empty()) {
             (makeAssemblerLine(Instr::UNTR)).appendOnto(toplevel);
             vm.state.stack = pushNode(vm.state.stack, vm.state.cont);
             unit->instructions() = toplevel;
@@ -214,29 +293,10 @@ bool readFileSource(string fname,
 #ifdef DEBUG_LOADS
     cout << "Loading " << fname << "..." << endl;
 #endif
-    ifstream file;
-    file.exceptions(ifstream::failbit | ifstream::badbit);
     try {
-        file.open(fname);
-        BOOST_SCOPE_EXIT(&file) {
-            file.close();
-        } BOOST_SCOPE_EXIT_END;
-        stringstream str;
-        while ((file >> str.rdbuf()).good());
         try {
-            auto stmts = parse(table, fname, str.str());
-            for (auto& stmt : stmts)
-                stmt->propogateFileName(fname);
-            list< shared_ptr<Stmt> > stmts1;
-            for (unique_ptr<Stmt>& stmt : stmts)
-                stmts1.push_back(shared_ptr<Stmt>(move(stmt)));
             TranslationUnitPtr unit = make_shared<TranslationUnit>();
-            InstrSeq toplevel;
-            (makeAssemblerLine(Instr::LOCFN, fname)).appendOnto(toplevel);
-            for (auto& stmt : stmts1) {
-                stmt->translate(*unit, toplevel);
-            }
-            (makeAssemblerLine(Instr::RET)).appendOnto(toplevel);
+            InstrSeq toplevel = translateFile(*unit, fname, table);
             auto lex = vm.state.lex.top();
             vm.state.lex.push(defScope.lex);
             if (!vm.state.dyn.empty()) {
@@ -248,7 +308,10 @@ bool readFileSource(string fname,
             vm.state.lex.top()->put(Symbols::get()["again"], mthd);
             vm.state.lex.top()->put(Symbols::get()["caller"], lex);
             unit->instructions() = toplevel;
+            optimize::standardPipeline(optimize::getLevel()).run(unit);
             optimize::lookupSymbols(unit);
+            if (optimize::getLevel() != optimize::Level::NONE)
+                optimize::fuseInstructions(unit);
             vm.state.stack = pushNode(vm.state.stack, vm.state.cont);
             vm.state.cont = MethodSeek(Method(unit, { 0 }));
             pushTrace(vm.state);
@@ -363,35 +426,17 @@ bool compileFile(string fname,
         } BOOST_SCOPE_EXIT_END;
         header = getFileHeaderSource(file0);
     }
-    ifstream file;
-    file.exceptions(ifstream::failbit | ifstream::badbit);
     try {
-        file.open(fname);
-        BOOST_SCOPE_EXIT(&file) {
-            file.close();
-        } BOOST_SCOPE_EXIT_END;
-        stringstream str;
-        while ((file >> str.rdbuf()).good());
         try {
-            auto stmts = parse(table, fname, str.str());
-            for (auto& stmt : stmts)
-                stmt->propogateFileName(fname);
-            list< shared_ptr<Stmt> > stmts1;
-            for (unique_ptr<Stmt>& stmt : stmts)
-                stmts1.push_back(shared_ptr<Stmt>(move(stmt)));
             TranslationUnitPtr unit = make_shared<TranslationUnit>();
-            InstrSeq toplevel;
-            (makeAssemblerLine(Instr::LOCFN, fname)).appendOnto(toplevel);
-            for (auto& stmt : stmts1) {
-                stmt->translate(*unit, toplevel);
-            }
-            (makeAssemblerLine(Instr::RET)).appendOnto(toplevel);
+            InstrSeq toplevel = translateFile(*unit, fname, table);
             ofstream file1;
             file1.open(fname1, std::ofstream::out | std::ofstream::binary);
             BOOST_SCOPE_EXIT(&file1) {
                 file1.close();
             } BOOST_SCOPE_EXIT_END;
             unit->instructions() = toplevel;
+            optimize::standardPipeline(optimize::getLevel()).run(unit);
             saveToFile(file1, header, unit);
         } catch (ParseError& e) {
             throwError(vm, "ParseError", e.getMessage());
@@ -431,6 +476,8 @@ bool readFileComp(string fname,
             vm.state.lex.top()->put(Symbols::get()["again"], mthd);
             vm.state.lex.top()->put(Symbols::get()["caller"], lex);
             optimize::lookupSymbols(unit);
+            if (optimize::getLevel() != optimize::Level::NONE)
+                optimize::fuseInstructions(unit);
             vm.state.stack = pushNode(vm.state.stack, vm.state.cont);
             vm.state.cont = MethodSeek(Method(unit, { 0 }));
             pushTrace(vm.state);
@@ -507,6 +554,18 @@ int Stmt::line() {
     return line_no;
 }
 
+void* Stmt::operator new(std::size_t size) {
+    if (currentArena != nullptr)
+        return currentArena->memory.allocate(size);
+    return ::operator new(size);
+}
+
+void Stmt::operator delete(void* ptr) noexcept {
+    if ((currentArena != nullptr) && (currentArena->memory.owns(ptr)))
+        return;
+    ::operator delete(ptr);
+}
+
 void Stmt::disableLocationInformation() {
     location = false;
 }
@@ -632,7 +691,7 @@ void StmtEqual::propogateFileName(std::string name) {
     Stmt::propogateFileName(name);
 }
 
-StmtMethod::StmtMethod(int line_no, std::list< std::shared_ptr<Stmt> >& contents)
+StmtMethod::StmtMethod(int line_no, ArgList& contents)
     : Stmt(line_no), contents(move(contents)) {}
 
 void StmtMethod::translate(TranslationUnit& unit, InstrSeq& seq) {
@@ -12,36 +12,13 @@ extern "C" {
 #include "Header.hpp"
 #include <memory>
 #include <functional>
+#include <fstream>
 #include <list>
 
 /// \file
 ///
 /// \brief Data structures and algorithms for translating and compiling the AST.
 
-/// A deleter for pointers to Expr or List values. This deleter will
-/// recursively free all of the memory associated with the entire tree
-/// pointed to by an Expr or List node.
-class ExprDeleter {
-public:
-
-    /// Frees the expression and all of its components recursively.
-    ///
-    /// \param x the expression
-    void operator()(Expr* x) const;
-
-    /// Frees the list and all of its elements recursively.
-    ///
-    /// \param x the list
-    void operator()(List* x) const;
-
-};
-
-/// A unique pointer to an Expr, with correct deletion semantics.
-using PtrToExpr = std::unique_ptr< Expr, ExprDeleter >;
-
-/// A unique pointer to a List, with correct deletion semantics.
-using PtrToList = std::unique_ptr< List, ExprDeleter >;
-
 class Stmt;
 
 /// \brief A scope consists of a lexical scoping object and a dynamic
@@ -57,50 +34,71 @@ struct Scope {
 
 };
 
-/// Sets the global variable associated with the current snippet of
-/// code. The global current line variable is a unique pointer, and it
-/// will <em>take ownership</em> of the argument.
+/// A callback which receives top-level statements one at a time, in
+/// the order in which they appear in the source. The statement lives
+/// in the parse arena and is only valid for the duration of the call.
+using StmtCallback = std::function<void(Stmt&)>;
+
+/// Allocates a zero-initialized Expr node in the current parse arena,
+/// or on the heap if no parse is in progress.
 ///
-/// This function (and, by extension, getCurrentLine()) is designed
-/// entirely to communicate with the C parser API.
+/// \return the new node
+extern "C" Expr* allocExpr();
+
+/// Allocates a zero-initialized List node in the current parse arena,
+/// or on the heap if no parse is in progress.
 ///
-/// \param stmt a list of statements to be placed in the variable
-extern "C" void setCurrentLine(List* stmt);
+/// \return the new node
+extern "C" List* allocList();
 
-/// Gets the value of the global variable associated with the current
-/// snippet. This function returns a unique pointer which takes
-/// ownership of the data, so the global variable will be left
-/// pointing at nothing after a call to this function.
+/// Returns whether a parse arena is active, in which case nodes are
+/// released in bulk and cleanupE() and cleanupL() do nothing.
 ///
-/// \return the global snippet
-PtrToList getCurrentLine();
-
-/// Translates the global current line into a list of Stmt objects. If
-/// there is no global current line, returns an empty list. This
-/// function, unlike getCurrentLine(), does not take ownership of the
-/// global line and only borrows it, so the current value of the line
-/// is unchanged.
+/// \return whether a parse is in progress
+extern "C" bool inParseArena();
+
+/// Called by the parser each time a complete top-level statement has
+/// been reduced. The statement is translated immediately with the
+/// operator table of the parse in progress and handed to that parse's
+/// callback, after which the parse arena, containing both the
+/// parser's nodes and the translated Stmt nodes, is released.
 ///
-/// \param table the operator table
-/// \return the translated statements, or the empty list
-std::list< std::unique_ptr<Stmt> > translateCurrentLine(const OperatorTable& table);
-
-/// Clears the global current line, freeing any memory associated with
-/// it and pointing it an nullptr.
-void clearCurrentLine() noexcept;
-
-/// Parses the given text as a sequence of Latitude expressions and
-/// compiles it into an AST made up of Stmt objects. If a parse error
-/// occurs, a ParseError exception will be raised.
+/// This function is designed entirely to communicate with the C
+/// parser API.
+///
+/// \param stmt a top-level statement
+extern "C" void emitLine(Expr* stmt);
+
+/// Parses the given text as a sequence of Latitude expressions,
+/// passing each top-level statement to the callback as soon as it has
+/// been parsed. Only one top-level statement is held in memory at a
+/// time. If a parse error occurs, a ParseError exception will be
+/// raised; statements preceding the error will already have been
+/// passed to the callback.
 ///
 /// \param table the operator precedence table
 /// \param filename the name of the file, used for error reporting
 /// \param str the Latitude code to parse
-/// \return the AST representing the code
+/// \param callback the function to receive each statement
+/// \throw ParseError if any part of the parsing process fails
+void parse(const OperatorTable& table,
+           std::string filename,
+           std::string str,
+           const StmtCallback& callback);
+
+/// Parses the file with the given name as a sequence of Latitude
+/// expressions, passing each top-level statement to the callback as
+/// soon as it has been parsed. The file is read incrementally by the
+/// scanner rather than loaded into memory up front.
+///
+/// \param table the operator precedence table
+/// \param filename the name of the file to read
+/// \param callback the function to receive each statement
 /// \throw ParseError if any part of the parsing process fails
-std::list< std::unique_ptr<Stmt> > parse(const OperatorTable& table,
-                                         std::string filename,
-                                         std::string str);
+/// \throw std::ios_base::failure if the file cannot be opened
+void parseFile(const OperatorTable& table,
+               std::string filename,
+               const StmtCallback& callback);
 
 /// Parses and compiles a string of Latitude code. The resulting
 /// instructions are placed in the VM's execution context to be
@@ -167,6 +165,14 @@ bool compileFile(std::string fname,
                  VMState& vm,
                  const OperatorTable& table);
 
+/// Loads a translation unit from a compiled bytecode file, which must
+/// be opened in binary mode. The header is read and discarded.
+///
+/// \param file the bytecode file
+/// \return the translation unit
+/// \throw HeaderError if the file header is invalid
+TranslationUnitPtr loadFromFile(std::ifstream& file);
+
 /// Parses and compiles (if necessary) a file of Latitude code. The
 /// resulting instructions will be placed in the VM's execution
 /// context to be executed next. Any errors during parsing will be
@@ -248,6 +254,22 @@ public:
     /// \param line_no the line number
     Stmt(int line_no);
 
+    virtual ~Stmt() = default;
+
+    /// Allocates memory for a statement. Statements constructed
+    /// during a parse live in the parse arena and are reclaimed in
+    /// bulk once their top-level statement has been handled.
+    ///
+    /// \param size the size of the statement object
+    /// \return the memory for the statement
+    static void* operator new(std::size_t size);
+
+    /// Frees the memory for a statement. Statements in the parse
+    /// arena are left for the arena to reclaim.
+    ///
+    /// \param ptr the statement's memory
+    static void operator delete(void* ptr) noexcept;
+
     /// Returns the line number, as passed into the constructor.
     ///
     /// \return the line number
@@ -335,14 +357,17 @@ public:
 
 /// A method literal.
 class StmtMethod : public Stmt {
+public:
+    /// The type of the method body for a StmtMethod object.
+    typedef std::list< std::unique_ptr<Stmt> > ArgList;
 private:
-    std::list< std::shared_ptr<Stmt> > contents;
+    ArgList contents;
 public:
     /// Constructs a StmtMethod.
     ///
     /// \param line_no the line number
     /// \param contents the body of the method
-    StmtMethod(int line_no, std::list< std::shared_ptr<Stmt> >& contents);
+    StmtMethod(int line_no, ArgList& contents);
     virtual void translate(TranslationUnit&, InstrSeq&);
     virtual void propogateFileName(std::string name);
 };
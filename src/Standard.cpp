@@ -9,6 +9,7 @@
 #include "Macro.hpp"
 #include "Header.hpp"
 #include "GC.hpp"
+#include "Allocator.hpp"
 #include "Environment.hpp"
 #include "Pathname.hpp"
 #include "Unicode.hpp"
@@ -17,9 +18,17 @@
 #include "Parents.hpp"
 #include "Precedence.hpp"
 #include "Input.hpp"
+#include "Optimizer.hpp"
+#include "Profiler.hpp"
+#include "Random.hpp"
 #include <list>
 #include <sstream>
 #include <fstream>
+#include <limits>
+#include <random>
+#include <chrono>
+#include <ctime>
+#include <system_error>
 #include <boost/scope_exit.hpp>
 #include <boost/optional.hpp>
 
@@ -51,6 +60,156 @@ Protection numToProtection(long num) {
     return prot;
 }
 
+// Gets the native storage of the array in %slf, throwing a TypeError
+// (and returning nullptr) if %slf is not an array.
+ArrayStore* arrayStore(VMState& vm) {
+    ArrayStore* store = boost::get<ArrayStore>(&vm.trans.slf->prim());
+    if (store == nullptr)
+        throwError(vm, "TypeError", "Array expected");
+    return store;
+}
+
+// Converts the index in %num0 to a position in an array (or any other
+// sequence) of the given size, using the standard indexing rules. If
+// %err0 is set or the index is not an integer, an ArgError is thrown,
+// and if the index is out of bounds, a BoundsError is thrown. In
+// either case, false is returned.
+bool arrayIndex(VMState& vm, size_t size0, size_t& pos) {
+    if (vm.trans.err0 || (vm.trans.num0.hierarchyLevel() > 1)) {
+        throwError(vm, "ArgError", "Non-integer indices are not valid");
+        return false;
+    }
+    long size = (long)size0;
+    long index = (vm.trans.num0.hierarchyLevel() == 0) ? vm.trans.num0.asSmallInt() : -size - 1;
+    if (index < 0)
+        index += size;
+    if ((index < 0) || (index >= size)) {
+        throwError(vm, "BoundsError");
+        return false;
+    }
+    pos = (size_t)index;
+    return true;
+}
+
+bool arrayIndex(VMState& vm, const ArrayStore& store, size_t& pos) {
+    return arrayIndex(vm, store.size(), pos);
+}
+
+// Gets the byte buffer in %slf, throwing a TypeError (and returning
+// nullptr) if %slf is not a byte buffer.
+const ByteBuffer* byteBuffer(VMState& vm) {
+    const ByteBuffer* buffer = boost::get<ByteBuffer>(&vm.trans.slf->prim());
+    if (buffer == nullptr)
+        throwError(vm, "TypeError", "ByteBuffer expected");
+    return buffer;
+}
+
+// Gets the string in %slf, together with its character index, throwing
+// a TypeError if %slf is not a string or a UTF8IntegrityError if the
+// string is not valid UTF-8. In either case, nullptr is returned. The
+// index is cached, so repeated calls on the same long string do not
+// rescan it.
+std::shared_ptr<const Utf8Index> textIndex(VMState& vm, const std::string*& str) {
+    str = boost::get<std::string>(&vm.trans.slf->prim());
+    if (str == nullptr) {
+        throwError(vm, "TypeError", "String expected");
+        return nullptr;
+    }
+    auto index = Utf8IndexCache::get().lookup(vm.trans.slf.get(), *str);
+    if (!index->isValid()) {
+        throwError(vm, "UTF8IntegrityError");
+        return nullptr;
+    }
+    return index;
+}
+
+// Converts a character position to one between 0 and the length of
+// the string, counting negative positions from the end.
+std::size_t clampCharPos(long pos, std::size_t length) {
+    if (pos < 0)
+        pos += (long)length;
+    if (pos < 0)
+        return 0;
+    return std::min((std::size_t)pos, length);
+}
+
+// Gets the pseudorandom generator in %slf, throwing a TypeError and
+// returning nullptr if there is none.
+RandomGenerator* randomGenerator(VMState& vm) {
+    RandomGenerator* gen = boost::get<RandomGenerator>(&vm.trans.slf->prim());
+    if (gen == nullptr)
+        throwError(vm, "TypeError", "Random generator expected");
+    return gen;
+}
+
+// Checks that a number is a valid upper bound for a pseudorandom
+// integer, throwing an ArgError if it is not.
+bool randomBound(VMState& vm, const Number& bound) {
+    if ((bound.hierarchyLevel() != 0) || (bound.asSmallInt() <= 0)) {
+        throwError(vm, "ArgError", "Bound must be a positive integer");
+        return false;
+    }
+    return true;
+}
+
+// Returns the current reading of the monotonic clock, in nanoseconds
+// since an arbitrary fixed point.
+long monotonicNanos() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+// Returns the processor time used by the process so far, in
+// nanoseconds.
+long cpuTimeNanos() {
+#ifdef USE_POSIX
+    timespec spec;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &spec) == 0)
+        return spec.tv_sec * 1000000000L + spec.tv_nsec;
+#endif
+    return (long)(std::clock() * (1000000000.0 / CLOCKS_PER_SEC));
+}
+
+// Constructs a new byte buffer object with the given contents.
+ObjectPtr garnishBytes(VMState& vm, ByteBuffer buffer) {
+    ObjectPtr obj = clone(vm.reader.lit.at(Lit::BYTES));
+    obj->prim() = std::move(buffer);
+    return obj;
+}
+
+// Gets the native storage of the dictionary in %slf, throwing a
+// TypeError (and returning nullptr) if %slf is not a dictionary.
+DictStore* dictStore(VMState& vm) {
+    DictStore* store = boost::get<DictStore>(&vm.trans.slf->prim());
+    if (store == nullptr)
+        throwError(vm, "TypeError", "Dict expected");
+    return store;
+}
+
+// Arranges for the block to be called with the element as its only
+// argument, after which the GTU method `next` resumes the
+// iteration. The block may be a method or any object with a `call`
+// slot, just as `Collection visit` allows. If the current
+// instruction is the last one in %cont, %cont is discarded rather
+// than saved, so that an iteration of any length runs in constant
+// %stack space.
+void visitElement(VMState& vm, ObjectPtr block, ObjectPtr elem, int next) {
+    if (boost::get<Method>(&block->prim()) != nullptr) {
+        vm.trans.ptr = block;
+    } else {
+        vm.trans.ptr = objectGet(block, Symbols::get()["call"]);
+        if (vm.trans.ptr == nullptr) {
+            throwError(vm, "TypeError", "Method expected");
+            return;
+        }
+    }
+    vm.trans.slf = block;
+    vm.trans.ret = elem;
+    if (vm.state.cont.position() + 1 < vm.state.cont.size())
+        vm.state.stack = pushNode(vm.state.stack, vm.state.cont);
+    vm.state.cont = MethodSeek(Method(vm.reader.gtu, { next }));
+}
+
 void spawnSystemCallsNew(ObjectPtr global,
                          ObjectPtr method,
                          ObjectPtr sys,
@@ -990,7 +1149,7 @@ void spawnSystemCallsNew(ObjectPtr global,
     // - 1 - Compare for LT and put the result in %flag
     // In any case, if either argument lacks a prim or the prim fields have different types, false
     // is returned by default.
-    // SIMPLE_CMP will compare strings, numbers, and symbols. Anything else returns false.
+    // SIMPLE_CMP will compare strings, numbers, symbols, and byte buffers. Anything else returns false.
     // primEquals#: lhs, rhs.
     // primLT#: lhs, rhs.
     assert(reader.cpp.size() == CPP_SIMPLE_CMP);
@@ -1005,20 +1164,24 @@ void spawnSystemCallsNew(ObjectPtr global,
                 vm.trans.flag = (*x == *y);
         };
         vm.trans.flag = false;
-        auto prim0 = vm.trans.slf->prim();
-        auto prim1 = vm.trans.ptr->prim();
+        auto& prim0 = vm.trans.slf->prim();
+        auto& prim1 = vm.trans.ptr->prim();
         auto n0 = boost::get<Number>(&prim0);
         auto n1 = boost::get<Number>(&prim1);
         auto st0 = boost::get<string>(&prim0);
         auto st1 = boost::get<string>(&prim1);
         auto sy0 = boost::get<Symbolic>(&prim0);
         auto sy1 = boost::get<Symbolic>(&prim1);
+        auto by0 = boost::get<ByteBuffer>(&prim0);
+        auto by1 = boost::get<ByteBuffer>(&prim1);
         if (n0 && n1)
             magicCmp(n0, n1);
         else if (st0 && st1)
             magicCmp(st0, st1);
         else if (sy0 && sy1)
             magicCmp(sy0, sy1);
+        else if (by0 && by1)
+            magicCmp(by0, by1);
     });
     sys->put(Symbols::get()["primEquals#"],
              defineMethod(unit, global, method,
@@ -2485,12 +2648,13 @@ void spawnSystemCallsNew(ObjectPtr global,
                                    makeAssemblerLine(Instr::CPP, CPP_UNI_CASE),
                                    makeAssemblerLine(Instr::THROA, "Internal error CPP_UNI_CASE"))));
 
-     // CPP_RANDOM (puts a random integer into %ret)
+     // CPP_RANDOM (puts a random nonnegative integer from the system's entropy source into %ret)
      // random#.
      assert(reader.cpp.size() == CPP_RANDOM);
      reader.cpp.push_back([](VMState& vm) {
-         // TODO Use the C++ random generator here, and try to make things thread-safe and not global
-         vm.trans.ret = garnishObject(vm.reader, rand());
+         static std::random_device device;
+         long value = ((long)device() << 31) ^ (long)device();
+         vm.trans.ret = garnishObject(vm.reader, value & std::numeric_limits<long>::max());
      });
      sys->put(Symbols::get()["random#"],
               defineMethod(unit, global, method,
@@ -2639,47 +2803,1679 @@ void spawnSystemCallsNew(ObjectPtr global,
                                    makeAssemblerLine(Instr::THROA, "Number expected"),
                                    makeAssemblerLine(Instr::CPP, CPP_LATVER))));
 
-     // GTU METHODS //
-
-     // These methods MUST be pushed in the correct order or the standard library
-     // code will fail spectacularly. The assertions here verify that that is the
-     // case.
-
-     FunctionIndex temp;
+     // CPP_SAMPLE_PROF (control the sampling profiler, based on %num0)
+     //  * 0 - Stop the profiler, writing its results
+     //  * 1 - Start the profiler, writing results to the file %str0
+     //  * 2 - Return whether the profiler is running
+     // profStop#.
+     // profStart#: filename.
+     // profRunning#.
+     assert(reader.cpp.size() == CPP_SAMPLE_PROF);
+     reader.cpp.push_back([](VMState& vm) {
+             switch (vm.trans.num0.asSmallInt()) {
+             case 0:
+                 SamplingProfiler::get().stop();
+                 vm.trans.ret = garnishObject(vm.reader, boost::blank());
+                 break;
+             case 1:
+                 SamplingProfiler::get().reset();
+                 if (SamplingProfiler::get().start(vm.trans.str0))
+                     vm.trans.ret = garnishObject(vm.reader, boost::blank());
+                 else
+                     throwError(vm, "NotSupportedError",
+                                "Sampling profiler not supported on this system");
+                 break;
+             case 2:
+                 vm.trans.ret = garnishObject(vm.reader, SamplingProfiler::get().isEnabled());
+                 break;
+             }
+         });
+     sys->put(Symbols::get()["profStop#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::INT, 0L),
+                                   makeAssemblerLine(Instr::CPP, CPP_SAMPLE_PROF))));
+     sys->put(Symbols::get()["profStart#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::STR0),
+                                   makeAssemblerLine(Instr::THROA, "String expected"),
+                                   makeAssemblerLine(Instr::INT, 1L),
+                                   makeAssemblerLine(Instr::CPP, CPP_SAMPLE_PROF))));
+     sys->put(Symbols::get()["profRunning#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::INT, 2L),
+                                   makeAssemblerLine(Instr::CPP, CPP_SAMPLE_PROF))));
+
+     // CPP_ALLOC_PROF (control the allocation profiler, based on %num0)
+     //  * 0 - Stop the profiler, writing its results
+     //  * 1 - Start the profiler, writing results to the file %str0
+     // allocProfStop#.
+     // allocProfStart#: filename.
+     assert(reader.cpp.size() == CPP_ALLOC_PROF);
+     reader.cpp.push_back([](VMState& vm) {
+             switch (vm.trans.num0.asSmallInt()) {
+             case 0:
+                 AllocationProfiler::get().stop();
+                 break;
+             case 1:
+                 AllocationProfiler::get().reset();
+                 AllocationProfiler::get().start(vm.trans.str0, vm.state);
+                 break;
+             }
+             vm.trans.ret = garnishObject(vm.reader, boost::blank());
+         });
+     sys->put(Symbols::get()["allocProfStop#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::INT, 0L),
+                                   makeAssemblerLine(Instr::CPP, CPP_ALLOC_PROF))));
+     sys->put(Symbols::get()["allocProfStart#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::STR0),
+                                   makeAssemblerLine(Instr::THROA, "String expected"),
+                                   makeAssemblerLine(Instr::INT, 1L),
+                                   makeAssemblerLine(Instr::CPP, CPP_ALLOC_PROF))));
+
+     // CPP_GC_STATS (garbage collector telemetry, based on %num0)
+     //  * 0 - Put an object describing the collector's statistics in %ret
+     //  * 1 - Log each collection, as a line of JSON, to the file %str0
+     //  * 2 - Stop logging collections
+     // statsGC#.
+     // logGC#: filename.
+     // unlogGC#.
+     assert(reader.cpp.size() == CPP_GC_STATS);
+     reader.cpp.push_back([](VMState& vm) {
+             switch (vm.trans.num0.asSmallInt()) {
+             case 0: {
+                 const GCStats& stats = GC::get().getStats();
+                 const GCCollectionStats& last = stats.last;
+                 ObjectPtr obj = clone(vm.reader.lit.at(Lit::OBJECT));
+                 auto put = [&obj, &vm](std::string name, long value) {
+                     obj->put(Symbols::get()[name], garnishObject(vm.reader, value));
+                 };
+                 put("collections", (long)stats.collections);
+                 put("totalPause", stats.totalPause);
+                 put("maxPause", stats.maxPause);
+                 put("medianPause", stats.pausePercentile(0.5));
+                 put("p99Pause", stats.pausePercentile(0.99));
+                 put("lastPause", last.pause);
+                 put("marked", (long)last.marked);
+                 put("freed", (long)last.freed);
+                 put("heapBefore", (long)last.heapBefore);
+                 put("heapAfter", (long)last.heapAfter);
+                 put("limit", (long)GC::get().getLimit());
+                 AllocatorStats alloc = Allocator::get().stats();
+                 put("buckets", (long)alloc.buckets);
+                 put("capacity", (long)alloc.capacity);
+                 put("used", (long)alloc.used);
+                 put("holes", (long)alloc.holes);
+                 double frag = (alloc.capacity == 0) ? 0.0 : (double)alloc.holes / alloc.capacity;
+                 obj->put(Symbols::get()["fragmentation"], garnishObject(vm.reader, Number(frag)));
+                 vm.trans.ret = obj;
+                 break;
+             }
+             case 1:
+                 GC::get().setStatsFile(vm.trans.str0);
+                 vm.trans.ret = garnishObject(vm.reader, boost::blank());
+                 break;
+             case 2:
+                 GC::get().setStatsFile("");
+                 vm.trans.ret = garnishObject(vm.reader, boost::blank());
+                 break;
+             }
+         });
+     sys->put(Symbols::get()["statsGC#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::INT, 0L),
+                                   makeAssemblerLine(Instr::CPP, CPP_GC_STATS))));
+     sys->put(Symbols::get()["logGC#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::STR0),
+                                   makeAssemblerLine(Instr::THROA, "String expected"),
+                                   makeAssemblerLine(Instr::INT, 1L),
+                                   makeAssemblerLine(Instr::CPP, CPP_GC_STATS))));
+     sys->put(Symbols::get()["unlogGC#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::INT, 2L),
+                                   makeAssemblerLine(Instr::CPP, CPP_GC_STATS))));
 
-     // GTU_EMPTY
-     reader.gtu->method(0) = asmCode();
+     // CPP_ARRAY_NTH (get the element of the array %slf at index %num0, storing it in %ret)
+     // arrNth#: arr, n.
+     assert(reader.cpp.size() == CPP_ARRAY_NTH);
+     reader.cpp.push_back([](VMState& vm) {
+             size_t pos;
+             const ArrayStore* store = arrayStore(vm);
+             if ((store != nullptr) && arrayIndex(vm, *store, pos))
+                 vm.trans.ret = store->elements()[pos];
+         });
+     sys->put(Symbols::get()["arrNth#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::NUM0),
+                                   makeAssemblerLine(Instr::CPP, CPP_ARRAY_NTH))));
 
-     // GTU_LOOP_DO
-     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::PUSH, Reg::PTR, Reg::STO),
-                                           makeAssemblerLine(Instr::MOV, Reg::PTR, Reg::SLF),
-                                           makeAssemblerLine(Instr::CALL, 0L),
-                                           makeAssemblerLine(Instr::POP, Reg::PTR, Reg::STO),
-                                           makeAssemblerLine(Instr::CPP, CPP_LOOP_DO)));
-     assert(temp.index == GTU_LOOP_DO);
+     // CPP_ARRAY_PUT (store %ptr in the array %slf at index %num0, storing %ptr in %ret)
+     // arrPut#: arr, n, value.
+     assert(reader.cpp.size() == CPP_ARRAY_PUT);
+     reader.cpp.push_back([](VMState& vm) {
+             size_t pos;
+             ArrayStore* store = arrayStore(vm);
+             if ((store != nullptr) && arrayIndex(vm, *store, pos)) {
+                 store->elements()[pos] = vm.trans.ptr;
+                 vm.trans.ret = vm.trans.ptr;
+             }
+         });
+     sys->put(Symbols::get()["arrPut#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::NUM0),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$3"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_ARRAY_PUT))));
+
+     // CPP_ARRAY_PUSH (push %ptr onto the array %slf, storing %ptr in %ret, based on %num0)
+     //  * 0 - Push onto the back
+     //  * 1 - Push onto the front
+     // arrPushBack#: arr, value.
+     // arrPushFront#: arr, value.
+     assert(reader.cpp.size() == CPP_ARRAY_PUSH);
+     reader.cpp.push_back([](VMState& vm) {
+             ArrayStore* store = arrayStore(vm);
+             if (store == nullptr)
+                 return;
+             if (vm.trans.num0.asSmallInt() == 0)
+                 store->elements().push_back(vm.trans.ptr);
+             else
+                 store->elements().push_front(vm.trans.ptr);
+             vm.trans.ret = vm.trans.ptr;
+         });
+     sys->put(Symbols::get()["arrPushBack#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::INT, 0L),
+                                   makeAssemblerLine(Instr::CPP, CPP_ARRAY_PUSH))));
+     sys->put(Symbols::get()["arrPushFront#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::INT, 1L),
+                                   makeAssemblerLine(Instr::CPP, CPP_ARRAY_PUSH))));
+
+     // CPP_ARRAY_POP (remove an element from the array %slf, storing it in %ret, based on %num0)
+     //  * 0 - Pop from the back
+     //  * 1 - Pop from the front
+     // arrPopBack#: arr.
+     // arrPopFront#: arr.
+     assert(reader.cpp.size() == CPP_ARRAY_POP);
+     reader.cpp.push_back([](VMState& vm) {
+             ArrayStore* store = arrayStore(vm);
+             if (store == nullptr)
+                 return;
+             if (store->size() == 0) {
+                 throwError(vm, "BoundsError");
+                 return;
+             }
+             std::deque<ObjectPtr>& elements = store->elements();
+             if (vm.trans.num0.asSmallInt() == 0) {
+                 vm.trans.ret = elements.back();
+                 elements.pop_back();
+             } else {
+                 vm.trans.ret = elements.front();
+                 elements.pop_front();
+             }
+         });
+     sys->put(Symbols::get()["arrPopBack#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                   makeAssemblerLine(Instr::INT, 0L),
+                                   makeAssemblerLine(Instr::CPP, CPP_ARRAY_POP))));
+     sys->put(Symbols::get()["arrPopFront#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                   makeAssemblerLine(Instr::INT, 1L),
+                                   makeAssemblerLine(Instr::CPP, CPP_ARRAY_POP))));
 
-     // GTU_RETURN
-     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::RET)));
-     assert(temp.index == GTU_RETURN);
+     // CPP_ARRAY_SIZE (store the number of elements in the array %slf in %ret)
+     // arrSize#: arr.
+     assert(reader.cpp.size() == CPP_ARRAY_SIZE);
+     reader.cpp.push_back([](VMState& vm) {
+             ArrayStore* store = arrayStore(vm);
+             if (store != nullptr)
+                 vm.trans.ret = garnishObject(vm.reader, (long)store->size());
+         });
+     sys->put(Symbols::get()["arrSize#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                   makeAssemblerLine(Instr::CPP, CPP_ARRAY_SIZE))));
 
-     // GTU_THROW
-     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::THROW)));
-     assert(temp.index == GTU_THROW);
+     // CPP_DICT_GET (look up the key %ptr in the dictionary %slf, storing the value in %ret)
+     // dictGet#: dict, key.
+     assert(reader.cpp.size() == CPP_DICT_GET);
+     reader.cpp.push_back([](VMState& vm) {
+             DictStore* store = dictStore(vm);
+             if (store == nullptr)
+                 return;
+             ObjectPtr value = store->get(vm.trans.ptr);
+             if (value == nullptr)
+                 throwError(vm, "TypeError", "Key not found");
+             else
+                 vm.trans.ret = value;
+         });
+     sys->put(Symbols::get()["dictGet#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_DICT_GET))));
 
-     // GTU_TERMINATE
-     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::CPP, CPP_TERMINATE)));
-     assert(temp.index == GTU_TERMINATE);
+     // CPP_DICT_PUT (associate the key %ret with %ptr in the dictionary %slf, storing %ptr in %ret)
+     // dictPut#: dict, key, value.
+     assert(reader.cpp.size() == CPP_DICT_PUT);
+     reader.cpp.push_back([](VMState& vm) {
+             DictStore* store = dictStore(vm);
+             if (store == nullptr)
+                 return;
+             store->put(vm.trans.ret, vm.trans.ptr);
+             vm.trans.ret = vm.trans.ptr;
+         });
+     sys->put(Symbols::get()["dictPut#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$3"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::POP, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_DICT_PUT))));
 
-     // GTU_HANDLER
-     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::POP, Reg::SLF, Reg::HAND),
-                                           makeAssemblerLine(Instr::PEEK, Reg::SLF, Reg::ARG),
-                                           makeAssemblerLine(Instr::POP, Reg::PTR, Reg::STO),
-                                           makeAssemblerLine(Instr::CALL, 1L)));
-     assert(temp.index == GTU_HANDLER);
+     // CPP_DICT_HAS (check whether the key %ptr is in the dictionary %slf, storing a Boolean in %ret)
+     // dictHas#: dict, key.
+     assert(reader.cpp.size() == CPP_DICT_HAS);
+     reader.cpp.push_back([](VMState& vm) {
+             DictStore* store = dictStore(vm);
+             if (store != nullptr)
+                 vm.trans.ret = garnishObject(vm.reader, store->get(vm.trans.ptr) != nullptr);
+         });
+     sys->put(Symbols::get()["dictHas#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_DICT_HAS))));
 
-     // GTU_CALL_ONE
-     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::CALL, 1L)));
-     assert(temp.index == GTU_CALL_ONE);
+     // CPP_DICT_DELETE (remove the key %ptr from the dictionary %slf, storing a Boolean in %ret)
+     // dictDelete#: dict, key.
+     assert(reader.cpp.size() == CPP_DICT_DELETE);
+     reader.cpp.push_back([](VMState& vm) {
+             DictStore* store = dictStore(vm);
+             if (store != nullptr)
+                 vm.trans.ret = garnishObject(vm.reader, store->remove(vm.trans.ptr));
+         });
+     sys->put(Symbols::get()["dictDelete#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_DICT_DELETE))));
+
+     // CPP_DICT_SIZE (store the number of entries in the dictionary %slf in %ret)
+     // dictSize#: dict.
+     assert(reader.cpp.size() == CPP_DICT_SIZE);
+     reader.cpp.push_back([](VMState& vm) {
+             DictStore* store = dictStore(vm);
+             if (store != nullptr)
+                 vm.trans.ret = garnishObject(vm.reader, (long)store->size());
+         });
+     sys->put(Symbols::get()["dictSize#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                   makeAssemblerLine(Instr::CPP, CPP_DICT_SIZE))));
+
+     // CPP_DICT_KEYS (store a new array of the keys of the dictionary %slf, in insertion order, in %ret)
+     // dictKeys#: dict.
+     assert(reader.cpp.size() == CPP_DICT_KEYS);
+     reader.cpp.push_back([](VMState& vm) {
+             DictStore* store = dictStore(vm);
+             if (store == nullptr)
+                 return;
+             ObjectPtr arr = clone(vm.reader.lit.at(Lit::ARRAY));
+             ArrayStore keys;
+             std::vector<ObjectPtr> keys0 = store->keys();
+             keys.elements().assign(keys0.begin(), keys0.end());
+             arr->prim() = std::move(keys);
+             vm.trans.ret = arr;
+         });
+     sys->put(Symbols::get()["dictKeys#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                   makeAssemblerLine(Instr::CPP, CPP_DICT_KEYS))));
+
+     // CPP_ARRAY_VISIT (call the block on each element of the array, in order)
+     // The %sto stack holds the array, the block, and the index of the
+     // next element (Nil initially). The array is indexed afresh at each
+     // step, so that, as with ArrayIterator, elements added during the
+     // iteration are visited. When the iteration finishes, the three
+     // values are popped and the array is stored in %ret.
+     // arrVisit#: arr, block.
+     assert(reader.cpp.size() == CPP_ARRAY_VISIT);
+     reader.cpp.push_back([](VMState& vm) {
+             ObjectPtr cursor = vm.state.sto.top();
+             vm.state.sto.pop();
+             ObjectPtr block = vm.state.sto.top();
+             vm.state.sto.pop();
+             ObjectPtr arr = vm.state.sto.top();
+             auto store = boost::get<ArrayStore>(&arr->prim());
+             auto index0 = boost::get<Number>(&cursor->prim());
+             long index = (index0 != nullptr) ? index0->asSmallInt() : 0;
+             if ((store == nullptr) || (index >= (long)store->size())) {
+                 vm.state.sto.pop();
+                 if (store == nullptr)
+                     throwError(vm, "TypeError", "Array expected");
+                 else
+                     vm.trans.ret = arr;
+                 return;
+             }
+             ObjectPtr elem = static_cast<const ArrayStore*>(store)->elements()[index];
+             vm.state.sto.push(block);
+             vm.state.sto.push(garnishObject(vm.reader, index + 1));
+             visitElement(vm, block, elem, GTU_ARRAY_VISIT);
+         });
+     sys->put(Symbols::get()["arrVisit#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::YLD, Lit::NIL, Reg::RET),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_ARRAY_VISIT))));
+
+     // CPP_RANGE_VISIT (call the block on each number in the range, in order)
+     // The %sto stack holds the end of the range, the step, the block,
+     // and the next number. The iteration ends, as with RangeIterator,
+     // once (finish - pos) * step <= 0, at which point the four values
+     // are popped and Nil is stored in %ret.
+     // rangeVisit#: start, finish, step, block.
+     assert(reader.cpp.size() == CPP_RANGE_VISIT);
+     reader.cpp.push_back([](VMState& vm) {
+             ObjectPtr cursor = vm.state.sto.top();
+             vm.state.sto.pop();
+             ObjectPtr block = vm.state.sto.top();
+             vm.state.sto.pop();
+             ObjectPtr step = vm.state.sto.top();
+             vm.state.sto.pop();
+             ObjectPtr finish = vm.state.sto.top();
+             auto pos0 = boost::get<Number>(&cursor->prim());
+             auto step0 = boost::get<Number>(&step->prim());
+             auto finish0 = boost::get<Number>(&finish->prim());
+             if ((pos0 == nullptr) || (step0 == nullptr) || (finish0 == nullptr)) {
+                 vm.state.sto.pop();
+                 throwError(vm, "TypeError", "Number expected");
+                 return;
+             }
+             if ((*finish0 - *pos0) * *step0 <= Number(0L)) {
+                 vm.state.sto.pop();
+                 vm.trans.ret = garnishObject(vm.reader, boost::blank());
+                 return;
+             }
+             vm.state.sto.push(step);
+             vm.state.sto.push(block);
+             vm.state.sto.push(garnishObject(vm.reader, *pos0 + *step0));
+             visitElement(vm, block, cursor, GTU_RANGE_VISIT);
+         });
+     sys->put(Symbols::get()["rangeVisit#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$3"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$4"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_RANGE_VISIT))));
+
+     // CPP_PROCESS_ARGS (%slf should be `Process`, %ptr an array of strings, and %ret will be a new clone)
+     // Like the Create task of CPP_PROCESS_TASK, but the process runs the
+     // program named by the first string directly, with the remaining
+     // strings as its arguments, rather than by way of the shell.
+     // processCreateArgs#: self, arr.
+     assert(reader.cpp.size() == CPP_PROCESS_ARGS);
+     reader.cpp.push_back([](VMState& vm) {
+         auto store = boost::get<ArrayStore>(&vm.trans.ptr->prim());
+         if (store == nullptr) {
+             throwError(vm, "TypeError", "Array expected");
+             return;
+         }
+         std::vector<std::string> args;
+         for (const ObjectPtr& arg : static_cast<const ArrayStore*>(store)->elements()) {
+             auto arg0 = boost::get<std::string>(&arg->prim());
+             if (arg0 == nullptr) {
+                 throwError(vm, "TypeError", "String expected");
+                 return;
+             }
+             args.push_back(*arg0);
+         }
+         if (args.empty()) {
+             throwError(vm, "SystemArgError", "Program name expected");
+             return;
+         }
+         ProcessPtr proc = makeProcess(args);
+         if (!proc) {
+             throwError(vm, "NotSupportedError",
+                        "Asynchronous processes not supported on this system");
+             return;
+         }
+         vm.trans.ret = clone(vm.trans.slf);
+         vm.trans.ret->prim(proc);
+     });
+     sys->put(Symbols::get()["processCreateArgs#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_PROCESS_ARGS))));
+
+     // CPP_STREAM_READY (takes %strm and outputs whether it can be read without blocking into %flag)
+     // streamReady#: strm.
+     assert(reader.cpp.size() == CPP_STREAM_READY);
+     reader.cpp.push_back([](VMState& vm) {
+         if (vm.trans.strm->hasIn())
+             vm.trans.flag = vm.trans.strm->isReady();
+         else
+             throwError(vm, "IOError", "Stream not designated for input");
+     });
+     sys->put(Symbols::get()["streamReady#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::STRM),
+                                   makeAssemblerLine(Instr::THROA, "Stream expected"),
+                                   makeAssemblerLine(Instr::CPP, CPP_STREAM_READY),
+                                   makeAssemblerLine(Instr::BOL))));
+
+     // CPP_STREAM_READ_AVAIL (reads whatever input %strm has available without blocking into %ret)
+     // The result is empty if nothing is available or the stream is at
+     // its end; `eof?` distinguishes the two.
+     // streamReadAvail#: strm.
+     assert(reader.cpp.size() == CPP_STREAM_READ_AVAIL);
+     reader.cpp.push_back([](VMState& vm) {
+         Stream& stream = *vm.trans.strm;
+         if (!stream.hasIn()) {
+             throwError(vm, "IOError", "Stream not designated for input");
+             return;
+         }
+         std::string result;
+         if (stream.isReady() && !stream.isEof()) {
+             result.resize(BufferedStream::BUFFER_SIZE);
+             result.resize(stream.read(&result[0], result.size()));
+         }
+         vm.trans.ret = garnishObject(vm.reader, result);
+     });
+     sys->put(Symbols::get()["streamReadAvail#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::STRM),
+                                   makeAssemblerLine(Instr::THROA, "Stream expected"),
+                                   makeAssemblerLine(Instr::CPP, CPP_STREAM_READ_AVAIL))));
+
+     // CPP_STREAM_POLL (waits for any of an array of streams to be ready for reading)
+     // %ptr is the array and %ret the timeout in milliseconds (or Nil to
+     // wait indefinitely). Outputs a new array of the ready streams into
+     // %ret.
+     // streamPoll#: arr, timeout.
+     assert(reader.cpp.size() == CPP_STREAM_POLL);
+     reader.cpp.push_back([](VMState& vm) {
+         auto store = boost::get<ArrayStore>(&vm.trans.ptr->prim());
+         if (store == nullptr) {
+             throwError(vm, "TypeError", "Array expected");
+             return;
+         }
+         long timeout = -1;
+         if (auto timeout0 = boost::get<Number>(&vm.trans.ret->prim()))
+             timeout = std::max(timeout0->asSmallInt(), 0L);
+         else if (boost::get<boost::blank>(&vm.trans.ret->prim()) == nullptr) {
+             throwError(vm, "TypeError", "Number expected");
+             return;
+         }
+         const std::deque<ObjectPtr>& elements = static_cast<const ArrayStore*>(store)->elements();
+         std::vector<StreamPtr> streams;
+         for (const ObjectPtr& elem : elements) {
+             auto stream0 = boost::get<StreamPtr>(&elem->prim());
+             if (stream0 == nullptr) {
+                 throwError(vm, "TypeError", "Stream expected");
+                 return;
+             }
+             streams.push_back(*stream0);
+         }
+         std::vector<std::size_t> indices;
+         try {
+             indices = pollStreams(streams, timeout);
+         } catch (std::system_error& e) {
+             throwError(vm, "IOError", e.code().message());
+             return;
+         }
+         ObjectPtr arr = clone(vm.reader.lit.at(Lit::ARRAY));
+         ArrayStore ready;
+         for (std::size_t index : indices)
+             ready.elements().push_back(elements[index]);
+         arr->prim() = std::move(ready);
+         vm.trans.ret = arr;
+     });
+     sys->put(Symbols::get()["streamPoll#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::CPP, CPP_STREAM_POLL))));
+
+     // CPP_STREAM_READ_ALL (reads the rest of the input from %strm into %ret)
+     // streamReadAll#: strm.
+     assert(reader.cpp.size() == CPP_STREAM_READ_ALL);
+     reader.cpp.push_back([](VMState& vm) {
+         if (vm.trans.strm->hasIn())
+             vm.trans.ret = garnishObject(vm.reader, vm.trans.strm->readAll());
+         else
+             throwError(vm, "IOError", "Stream not designated for input");
+     });
+     sys->put(Symbols::get()["streamReadAll#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::STRM),
+                                   makeAssemblerLine(Instr::THROA, "Stream expected"),
+                                   makeAssemblerLine(Instr::CPP, CPP_STREAM_READ_ALL))));
+
+     // CPP_STREAM_LINE (reads the next line from %strm into %ret, or Nil if there are no more)
+     // Unlike streamRead#, a newline at the very end of the input does
+     // not produce an additional empty line.
+     // streamLine#: strm.
+     assert(reader.cpp.size() == CPP_STREAM_LINE);
+     reader.cpp.push_back([](VMState& vm) {
+         Stream& stream = *vm.trans.strm;
+         if (!stream.hasIn()) {
+             throwError(vm, "IOError", "Stream not designated for input");
+             return;
+         }
+         std::string line = stream.readLine();
+         if (line.empty() && stream.isEof())
+             vm.trans.ret = garnishObject(vm.reader, boost::blank());
+         else
+             vm.trans.ret = garnishObject(vm.reader, line);
+     });
+     sys->put(Symbols::get()["streamLine#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::STRM),
+                                   makeAssemblerLine(Instr::THROA, "Stream expected"),
+                                   makeAssemblerLine(Instr::CPP, CPP_STREAM_LINE))));
+
+     // CPP_STREAM_READ_BYTES (reads up to %ret bytes from %strm into a new byte buffer in %ret)
+     // If %ret is Nil, the rest of the input is read. Fewer bytes are
+     // returned only at the end of the input.
+     // streamReadBytes#: strm, count.
+     assert(reader.cpp.size() == CPP_STREAM_READ_BYTES);
+     reader.cpp.push_back([](VMState& vm) {
+         Stream& stream = *vm.trans.strm;
+         if (!stream.hasIn()) {
+             throwError(vm, "IOError", "Stream not designated for input");
+             return;
+         }
+         if (boost::get<boost::blank>(&vm.trans.ret->prim()) != nullptr) {
+             vm.trans.ret = garnishBytes(vm, ByteBuffer(stream.readAll()));
+             return;
+         }
+         auto count0 = boost::get<Number>(&vm.trans.ret->prim());
+         if ((count0 == nullptr) || (count0->hierarchyLevel() > 0)) {
+             throwError(vm, "TypeError", "Integer expected");
+             return;
+         }
+         std::size_t count = (std::size_t)std::max(count0->asSmallInt(), 0L);
+         // Grow the result a buffer at a time, so that a large count
+         // near the end of the input does not allocate the full amount.
+         std::string bytes;
+         while (bytes.size() < count) {
+             std::size_t prior = bytes.size();
+             bytes.resize(prior + std::min(count - prior, BufferedStream::BUFFER_SIZE));
+             std::size_t amount = stream.read(&bytes[prior], bytes.size() - prior);
+             bytes.resize(prior + amount);
+             if (amount == 0)
+                 break;
+         }
+         vm.trans.ret = garnishBytes(vm, ByteBuffer(std::move(bytes)));
+     });
+     sys->put(Symbols::get()["streamReadBytes#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::STRM),
+                                   makeAssemblerLine(Instr::THROA, "Stream expected"),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::CPP, CPP_STREAM_READ_BYTES))));
+
+     // CPP_STREAM_WRITE_BYTES (writes the byte buffer %ptr to %strm)
+     // streamWriteBytes#: strm, buffer.
+     assert(reader.cpp.size() == CPP_STREAM_WRITE_BYTES);
+     reader.cpp.push_back([](VMState& vm) {
+         Stream& stream = *vm.trans.strm;
+         auto buffer = boost::get<ByteBuffer>(&vm.trans.ptr->prim());
+         if (buffer == nullptr) {
+             throwError(vm, "TypeError", "ByteBuffer expected");
+             return;
+         }
+         if (!stream.hasOut()) {
+             throwError(vm, "IOError", "Stream not designated for output");
+             return;
+         }
+         stream.write(buffer->data(), buffer->size());
+         vm.trans.ret = garnishObject(vm.reader, boost::blank());
+     });
+     sys->put(Symbols::get()["streamWriteBytes#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::STRM),
+                                   makeAssemblerLine(Instr::THROA, "Stream expected"),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::CPP, CPP_STREAM_WRITE_BYTES))));
+
+     // CPP_BYTES_SIZE (store the number of bytes in the byte buffer %slf in %ret)
+     // bytesSize#: buffer.
+     assert(reader.cpp.size() == CPP_BYTES_SIZE);
+     reader.cpp.push_back([](VMState& vm) {
+             const ByteBuffer* buffer = byteBuffer(vm);
+             if (buffer != nullptr)
+                 vm.trans.ret = garnishObject(vm.reader, (long)buffer->size());
+         });
+     sys->put(Symbols::get()["bytesSize#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                   makeAssemblerLine(Instr::CPP, CPP_BYTES_SIZE))));
+
+     // CPP_BYTES_NTH (store the byte of the byte buffer %slf at index %num0, as a number, in %ret)
+     // Indices follow the same rules as arrNth#.
+     // bytesNth#: buffer, n.
+     assert(reader.cpp.size() == CPP_BYTES_NTH);
+     reader.cpp.push_back([](VMState& vm) {
+             size_t pos;
+             const ByteBuffer* buffer = byteBuffer(vm);
+             if ((buffer != nullptr) && arrayIndex(vm, buffer->size(), pos))
+                 vm.trans.ret = garnishObject(vm.reader, (long)(*buffer)[pos]);
+         });
+     sys->put(Symbols::get()["bytesNth#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::NUM0),
+                                   makeAssemblerLine(Instr::CPP, CPP_BYTES_NTH))));
+
+     // CPP_BYTES_SLICE (store the part of the byte buffer %slf from %num0 to %num1 in %ret)
+     // The bounds follow the same rules as stringSubstring#. The slice
+     // shares its bytes with the original buffer.
+     // bytesSlice#: buffer, beg, end.
+     assert(reader.cpp.size() == CPP_BYTES_SLICE);
+     reader.cpp.push_back([](VMState& vm) {
+         const ByteBuffer* buffer = byteBuffer(vm);
+         if (buffer == nullptr)
+             return;
+         long size = (long)buffer->size();
+         long start1 = vm.trans.num0.asSmallInt();
+         long end1 = vm.trans.num1.asSmallInt();
+         if (start1 < 0)
+             start1 += size;
+         if (end1 < 0)
+             end1 += size;
+         start1 = std::max(start1, 0L);
+         end1 = std::max(end1, 0L);
+         vm.trans.ret = garnishBytes(vm, buffer->slice(start1, end1));
+     });
+     sys->put(Symbols::get()["bytesSlice#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$3"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::NUM1),
+                                   makeAssemblerLine(Instr::POP, Reg::PTR, Reg::STO),
+                                   makeAssemblerLine(Instr::EXPD, Reg::NUM0),
+                                   makeAssemblerLine(Instr::THROA, "Number expected"),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_BYTES_SLICE))));
+
+     // CPP_BYTES_CONCAT (store the bytes of %slf followed by those of %ptr in a new byte buffer in %ret)
+     // bytesConcat#: buffer, buffer.
+     assert(reader.cpp.size() == CPP_BYTES_CONCAT);
+     reader.cpp.push_back([](VMState& vm) {
+         const ByteBuffer* first = byteBuffer(vm);
+         if (first == nullptr)
+             return;
+         auto second = boost::get<ByteBuffer>(&vm.trans.ptr->prim());
+         if (second == nullptr) {
+             throwError(vm, "TypeError", "ByteBuffer expected");
+             return;
+         }
+         std::string bytes;
+         bytes.reserve(first->size() + second->size());
+         bytes.append(first->data(), first->size());
+         bytes.append(second->data(), second->size());
+         vm.trans.ret = garnishBytes(vm, ByteBuffer(std::move(bytes)));
+     });
+     sys->put(Symbols::get()["bytesConcat#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_BYTES_CONCAT))));
+
+     // CPP_BYTES_DECODE (decode an integer from the byte buffer %slf into %ret)
+     // The %sto stack holds the index of the first byte and, above it,
+     // the width of the integer in bytes, which must be between 1 and
+     // 8. %num0 specifies the encoding:
+     // - Bit 0 - Set for big-endian, clear for little-endian
+     // - Bit 1 - Set for two's complement signed, clear for unsigned
+     // bytesUIntLE#: buffer, index, width.
+     // bytesUIntBE#: buffer, index, width.
+     // bytesIntLE#: buffer, index, width.
+     // bytesIntBE#: buffer, index, width.
+     assert(reader.cpp.size() == CPP_BYTES_DECODE);
+     reader.cpp.push_back([](VMState& vm) {
+         ObjectPtr width = vm.state.sto.top();
+         vm.state.sto.pop();
+         ObjectPtr index = vm.state.sto.top();
+         vm.state.sto.pop();
+         const ByteBuffer* buffer = byteBuffer(vm);
+         if (buffer == nullptr)
+             return;
+         auto width0 = boost::get<Number>(&width->prim());
+         auto index0 = boost::get<Number>(&index->prim());
+         if ((width0 == nullptr) || (index0 == nullptr) ||
+             (width0->hierarchyLevel() > 0) || (index0->hierarchyLevel() > 0)) {
+             throwError(vm, "TypeError", "Integer expected");
+             return;
+         }
+         long width1 = width0->asSmallInt();
+         long index1 = index0->asSmallInt();
+         if ((width1 < 1) || (width1 > 8)) {
+             throwError(vm, "ArgError", "Integer width must be between 1 and 8 bytes");
+             return;
+         }
+         if ((index1 < 0) || (index1 + width1 > (long)buffer->size())) {
+             throwError(vm, "BoundsError");
+             return;
+         }
+         long mode = vm.trans.num0.asSmallInt();
+         std::uint64_t value = buffer->decode(index1, width1, mode & 1);
+         if ((mode & 2) && (width1 < 8) && (value >> (width1 * 8 - 1)))
+             value |= ~std::uint64_t(0) << (width1 * 8);
+         Number result;
+         if (mode & 2) {
+             auto signed0 = (std::int64_t)value;
+             if ((signed0 >= std::numeric_limits<long>::min()) &&
+                 (signed0 <= std::numeric_limits<long>::max()))
+                 result = Number((long)signed0);
+             else
+                 result = Number(Number::bigint(signed0));
+         } else {
+             if (value <= (std::uint64_t)std::numeric_limits<long>::max())
+                 result = Number((long)value);
+             else
+                 result = Number(Number::bigint(value));
+         }
+         vm.trans.ret = garnishObject(vm.reader, result);
+     });
+     {
+         const char* names[] = { "bytesUIntLE#", "bytesUIntBE#", "bytesIntLE#", "bytesIntBE#" };
+         for (long mode = 0; mode < 4; mode++) {
+             sys->put(Symbols::get()[names[mode]],
+                      defineMethod(unit, global, method,
+                                   asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                           makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                           makeAssemblerLine(Instr::RTRV),
+                                           makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                           makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                           makeAssemblerLine(Instr::SYMN, Symbols::get()["$3"].index),
+                                           makeAssemblerLine(Instr::RTRV),
+                                           makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                           makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                           makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                           makeAssemblerLine(Instr::RTRV),
+                                           makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                           makeAssemblerLine(Instr::INT, mode),
+                                           makeAssemblerLine(Instr::CPP, CPP_BYTES_DECODE))));
+         }
+     }
+
+     // CPP_BYTES_FROM (store a new byte buffer containing the bytes of %ptr in %ret)
+     // %ptr may be a string, whose bytes are copied, or an array of
+     // integers between 0 and 255.
+     // bytesFrom#: obj.
+     assert(reader.cpp.size() == CPP_BYTES_FROM);
+     reader.cpp.push_back([](VMState& vm) {
+         if (auto str = boost::get<std::string>(&vm.trans.ptr->prim())) {
+             vm.trans.ret = garnishBytes(vm, ByteBuffer(*str));
+             return;
+         }
+         auto store = boost::get<ArrayStore>(&vm.trans.ptr->prim());
+         if (store == nullptr) {
+             throwError(vm, "TypeError", "String or Array expected");
+             return;
+         }
+         const std::deque<ObjectPtr>& elements = static_cast<const ArrayStore*>(store)->elements();
+         std::string bytes;
+         bytes.reserve(elements.size());
+         for (const ObjectPtr& elem : elements) {
+             auto byte = boost::get<Number>(&elem->prim());
+             if ((byte == nullptr) || (byte->hierarchyLevel() > 0)) {
+                 throwError(vm, "TypeError", "Integer expected");
+                 return;
+             }
+             long byte1 = byte->asSmallInt();
+             if ((byte1 < 0) || (byte1 > 255)) {
+                 throwError(vm, "ArgError", "Byte must be between 0 and 255");
+                 return;
+             }
+             bytes.push_back((char)byte1);
+         }
+         vm.trans.ret = garnishBytes(vm, ByteBuffer(std::move(bytes)));
+     });
+     sys->put(Symbols::get()["bytesFrom#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::CPP, CPP_BYTES_FROM))));
+
+     // CPP_BYTES_TO_STRING (store a new string containing the bytes of the byte buffer %slf in %ret)
+     // bytesToString#: buffer.
+     assert(reader.cpp.size() == CPP_BYTES_TO_STRING);
+     reader.cpp.push_back([](VMState& vm) {
+             const ByteBuffer* buffer = byteBuffer(vm);
+             if (buffer != nullptr)
+                 vm.trans.ret = garnishObject(vm.reader, buffer->toString());
+         });
+     sys->put(Symbols::get()["bytesToString#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                   makeAssemblerLine(Instr::CPP, CPP_BYTES_TO_STRING))));
+
+     // CPP_STRING_CHAR_LENGTH (store the number of characters in the string %slf in %ret)
+     // stringCharLength#: str.
+     assert(reader.cpp.size() == CPP_STRING_CHAR_LENGTH);
+     reader.cpp.push_back([](VMState& vm) {
+             const std::string* str;
+             auto index = textIndex(vm, str);
+             if (index)
+                 vm.trans.ret = garnishObject(vm.reader, (long)index->length());
+         });
+     sys->put(Symbols::get()["stringCharLength#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                   makeAssemblerLine(Instr::CPP, CPP_STRING_CHAR_LENGTH))));
+
+     // CPP_STRING_OFFSET (convert between character positions and byte offsets in the string %slf)
+     // If %num0 is 0, %num1 is a character position (negative positions
+     // count from the end), and the byte offset at which that character
+     // begins is stored in %ret. If %num0 is 1, %num1 is a byte offset,
+     // and the position of the first character beginning at or after it
+     // is stored in %ret. Either input is clamped to the string.
+     // stringByteIndex#: str, pos.
+     // stringCharIndex#: str, offset.
+     assert(reader.cpp.size() == CPP_STRING_OFFSET);
+     reader.cpp.push_back([](VMState& vm) {
+         const std::string* str;
+         auto index = textIndex(vm, str);
+         if (!index)
+             return;
+         long value = vm.trans.num1.asSmallInt();
+         if (vm.trans.num0.asSmallInt() == 0) {
+             std::size_t pos = clampCharPos(value, index->length());
+             vm.trans.ret = garnishObject(vm.reader, (long)index->byteOffset(*str, pos));
+         } else {
+             std::size_t offset = std::min((std::size_t)std::max(value, 0L), str->size());
+             vm.trans.ret = garnishObject(vm.reader, (long)index->charPos(*str, offset));
+         }
+     });
+     for (long mode = 0; mode < 2; mode++) {
+         const char* name = (mode == 0) ? "stringByteIndex#" : "stringCharIndex#";
+         sys->put(Symbols::get()[name],
+                  defineMethod(unit, global, method,
+                               asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                       makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                       makeAssemblerLine(Instr::RTRV),
+                                       makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                       makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                       makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                       makeAssemblerLine(Instr::RTRV),
+                                       makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                       makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                       makeAssemblerLine(Instr::ECLR),
+                                       makeAssemblerLine(Instr::EXPD, Reg::NUM1),
+                                       makeAssemblerLine(Instr::THROA, "Number expected"),
+                                       makeAssemblerLine(Instr::INT, mode),
+                                       makeAssemblerLine(Instr::CPP, CPP_STRING_OFFSET))));
+     }
+
+     // CPP_STRING_SUB_CHARS (outputs substring of %slf from character %num0 to character %num1 into %ret)
+     // The bounds follow the same rules as stringSubstring#, but count
+     // characters rather than bytes.
+     // stringSubstringChars#: str, beg, end.
+     assert(reader.cpp.size() == CPP_STRING_SUB_CHARS);
+     reader.cpp.push_back([](VMState& vm) {
+         const std::string* str;
+         auto index = textIndex(vm, str);
+         if (!index)
+             return;
+         std::size_t start = clampCharPos(vm.trans.num0.asSmallInt(), index->length());
+         std::size_t end = clampCharPos(vm.trans.num1.asSmallInt(), index->length());
+         std::string result;
+         if (start < end) {
+             std::size_t start1 = index->byteOffset(*str, start);
+             std::size_t end1 = index->byteOffset(*str, end);
+             result = str->substr(start1, end1 - start1);
+         }
+         vm.trans.ret = garnishObject(vm.reader, result);
+     });
+     sys->put(Symbols::get()["stringSubstringChars#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$3"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::NUM1),
+                                   makeAssemblerLine(Instr::POP, Reg::PTR, Reg::STO),
+                                   makeAssemblerLine(Instr::EXPD, Reg::NUM0),
+                                   makeAssemblerLine(Instr::THROA, "Number expected"),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_STRING_SUB_CHARS))));
+
+     // CPP_STRING_SCAN (search the string %slf for every occurrence of %str1)
+     // The result stored in %ret depends on %num0. If %num0 is 0, it is
+     // an array of the pieces of the string between non-overlapping
+     // occurrences. If %num0 is 1, it is the number of non-overlapping
+     // occurrences. If %num0 is 2 or 3, it is an array of the positions
+     // of every (possibly overlapping) occurrence, in characters or in
+     // bytes respectively. Only counting characters requires the string
+     // to be valid UTF-8.
+     // stringSplit#: str, delim.
+     // stringCount#: str, substr.
+     // stringFindAll#: str, substr.
+     // stringFindAllBytes#: str, substr.
+     assert(reader.cpp.size() == CPP_STRING_SCAN);
+     reader.cpp.push_back([](VMState& vm) {
+         long mode = vm.trans.num0.asSmallInt();
+         const std::string* str;
+         std::shared_ptr<const Utf8Index> index;
+         if (mode == 2) {
+             index = textIndex(vm, str);
+             if (!index)
+                 return;
+         } else {
+             str = boost::get<std::string>(&vm.trans.slf->prim());
+             if (str == nullptr) {
+                 throwError(vm, "TypeError", "String expected");
+                 return;
+             }
+         }
+         if (vm.trans.str1.empty()) {
+             throwError(vm, "ArgError", "Empty substring");
+             return;
+         }
+         std::vector<std::size_t> matches = findAllBytes(*str, vm.trans.str1, mode >= 2);
+         if (mode == 1) {
+             vm.trans.ret = garnishObject(vm.reader, (long)matches.size());
+             return;
+         }
+         ObjectPtr arr = clone(vm.reader.lit.at(Lit::ARRAY));
+         ArrayStore elements;
+         if (mode == 0) {
+             std::size_t start = 0;
+             for (std::size_t match : matches) {
+                 elements.elements().push_back(garnishObject(vm.reader, str->substr(start, match - start)));
+                 start = match + vm.trans.str1.size();
+             }
+             elements.elements().push_back(garnishObject(vm.reader, str->substr(start)));
+         } else {
+             for (std::size_t match : matches) {
+                 long pos = (mode == 2) ? (long)index->charPos(*str, match) : (long)match;
+                 elements.elements().push_back(garnishObject(vm.reader, pos));
+             }
+         }
+         arr->prim() = std::move(elements);
+         vm.trans.ret = arr;
+     });
+     for (long mode = 0; mode < 4; mode++) {
+         const char* names[] = { "stringSplit#", "stringCount#", "stringFindAll#", "stringFindAllBytes#" };
+         sys->put(Symbols::get()[names[mode]],
+                  defineMethod(unit, global, method,
+                               asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                       makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                       makeAssemblerLine(Instr::RTRV),
+                                       makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                       makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                       makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                       makeAssemblerLine(Instr::RTRV),
+                                       makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                       makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                       makeAssemblerLine(Instr::ECLR),
+                                       makeAssemblerLine(Instr::EXPD, Reg::STR1),
+                                       makeAssemblerLine(Instr::THROA, "String expected"),
+                                       makeAssemblerLine(Instr::INT, mode),
+                                       makeAssemblerLine(Instr::CPP, CPP_STRING_SCAN))));
+     }
+
+     // CPP_STRING_REPLACE_ALL (replace the occurrences of %str1 in the string %slf)
+     // The occurrences are found as by stringSplit#, and the nth is
+     // replaced by the nth string in the array %ret. The new string is
+     // stored in %ret.
+     // stringReplaceAll#: str, substr, replacements.
+     assert(reader.cpp.size() == CPP_STRING_REPLACE_ALL);
+     reader.cpp.push_back([](VMState& vm) {
+         const std::string* str = boost::get<std::string>(&vm.trans.slf->prim());
+         if (str == nullptr) {
+             throwError(vm, "TypeError", "String expected");
+             return;
+         }
+         auto store = boost::get<ArrayStore>(&vm.trans.ret->prim());
+         if (store == nullptr) {
+             throwError(vm, "TypeError", "Array expected");
+             return;
+         }
+         if (vm.trans.str1.empty()) {
+             throwError(vm, "ArgError", "Empty substring");
+             return;
+         }
+         const std::deque<ObjectPtr>& replacements = static_cast<const ArrayStore*>(store)->elements();
+         std::vector<std::size_t> matches = findAllBytes(*str, vm.trans.str1, false);
+         if (replacements.size() < matches.size()) {
+             throwError(vm, "ArgError", "Too few replacements");
+             return;
+         }
+         std::string result;
+         result.reserve(str->size());
+         std::size_t start = 0;
+         for (std::size_t i = 0; i < matches.size(); i++) {
+             auto replacement = boost::get<std::string>(&replacements[i]->prim());
+             if (replacement == nullptr) {
+                 throwError(vm, "TypeError", "String expected");
+                 return;
+             }
+             result.append(*str, start, matches[i] - start);
+             result += *replacement;
+             start = matches[i] + vm.trans.str1.size();
+         }
+         result.append(*str, start, std::string::npos);
+         vm.trans.ret = garnishObject(vm.reader, result);
+     });
+     sys->put(Symbols::get()["stringReplaceAll#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$3"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::POP, Reg::PTR, Reg::STO),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::STR1),
+                                   makeAssemblerLine(Instr::THROA, "String expected"),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_STRING_REPLACE_ALL))));
+
+     // CPP_STRING_CASE (convert the whole string %slf to the given case, storing the result in %ret, based on the value of %num0)
+     // - 0 - Lower
+     // - 1 - Upper
+     // - 2 - Title
+     // - 3 - Lower (ASCII bytes only)
+     // - 4 - Upper (ASCII bytes only)
+     // - 5 - Title (ASCII bytes only)
+     // stringToLower#: str.
+     // stringToUpper#: str.
+     // stringToTitle#: str.
+     // bytesToLower#: str.
+     // bytesToUpper#: str.
+     // bytesToTitle#: str.
+     assert(reader.cpp.size() == CPP_STRING_CASE);
+     reader.cpp.push_back([](VMState& vm) {
+         const std::string* str = boost::get<std::string>(&vm.trans.slf->prim());
+         if (str == nullptr) {
+             throwError(vm, "TypeError", "String expected");
+             return;
+         }
+         long mode = vm.trans.num0.asSmallInt();
+         LetterCase letterCase = LetterCase::LOWER;
+         if (mode % 3 == 1)
+             letterCase = LetterCase::UPPER;
+         else if (mode % 3 == 2)
+             letterCase = LetterCase::TITLE;
+         if (mode >= 3) {
+             vm.trans.ret = garnishObject(vm.reader, convertAsciiCase(*str, letterCase));
+             return;
+         }
+         auto result = convertCase(*str, letterCase);
+         if (result)
+             vm.trans.ret = garnishObject(vm.reader, *result);
+         else
+             throwError(vm, "UTF8IntegrityError");
+     });
+     for (long mode = 0; mode < 6; mode++) {
+         const char* names[] = { "stringToLower#", "stringToUpper#", "stringToTitle#",
+                                 "bytesToLower#", "bytesToUpper#", "bytesToTitle#" };
+         sys->put(Symbols::get()[names[mode]],
+                  defineMethod(unit, global, method,
+                               asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                       makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                       makeAssemblerLine(Instr::RTRV),
+                                       makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                       makeAssemblerLine(Instr::INT, mode),
+                                       makeAssemblerLine(Instr::CPP, CPP_STRING_CASE))));
+     }
+
+     // CPP_STRING_CATEGORY_SPAN (count the characters at the start of the string %slf in the categories in the array %ptr)
+     // The categories are given by number, as returned by uniCat#, and
+     // the number of characters is stored in %ret.
+     // stringCategorySpan#: str, categories.
+     assert(reader.cpp.size() == CPP_STRING_CATEGORY_SPAN);
+     reader.cpp.push_back([](VMState& vm) {
+         const std::string* str = boost::get<std::string>(&vm.trans.slf->prim());
+         if (str == nullptr) {
+             throwError(vm, "TypeError", "String expected");
+             return;
+         }
+         auto store = boost::get<ArrayStore>(&vm.trans.ptr->prim());
+         if (store == nullptr) {
+             throwError(vm, "TypeError", "Array expected");
+             return;
+         }
+         unsigned long categories = 0;
+         for (const ObjectPtr& elem : static_cast<const ArrayStore*>(store)->elements()) {
+             auto cat = boost::get<Number>(&elem->prim());
+             if (cat == nullptr) {
+                 throwError(vm, "TypeError", "Number expected");
+                 return;
+             }
+             long value = cat->asSmallInt();
+             if ((value < 0) || (value > UNICLS_CN)) {
+                 throwError(vm, "ArgError", "Invalid category");
+                 return;
+             }
+             categories |= 1UL << value;
+         }
+         auto result = categorySpan(*str, categories);
+         if (result)
+             vm.trans.ret = garnishObject(vm.reader, (long)*result);
+         else
+             throwError(vm, "UTF8IntegrityError");
+     });
+     sys->put(Symbols::get()["stringCategorySpan#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_STRING_CATEGORY_SPAN))));
+
+     // CPP_RANDOM_SEED (seed a new pseudorandom generator in the primitive field of %slf from %num0)
+     // randomSeed#: obj, seed.
+     assert(reader.cpp.size() == CPP_RANDOM_SEED);
+     reader.cpp.push_back([](VMState& vm) {
+         if (vm.trans.num0.hierarchyLevel() > 0) {
+             throwError(vm, "ArgError", "Seed out of range");
+             return;
+         }
+         vm.trans.slf->prim(RandomGenerator(vm.trans.num0.asSmallInt()));
+     });
+     sys->put(Symbols::get()["randomSeed#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::NUM0),
+                                   makeAssemblerLine(Instr::THROA, "Number expected"),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_RANDOM_SEED))));
+
+     // CPP_RANDOM_NEXT (draw the next value from the pseudorandom generator %slf into %ret, based on the value of %num0)
+     // - 0 - A nonnegative integer
+     // - 1 - A nonnegative integer less than %num1
+     // - 2 - A floating point number in [0, 1)
+     // randomNext#: gen.
+     // randomBelow#: gen, bound.
+     // randomFloat#: gen.
+     assert(reader.cpp.size() == CPP_RANDOM_NEXT);
+     reader.cpp.push_back([](VMState& vm) {
+         RandomGenerator* gen = randomGenerator(vm);
+         if (gen == nullptr)
+             return;
+         switch (vm.trans.num0.asSmallInt()) {
+         case 0:
+             vm.trans.ret = garnishObject(vm.reader, (long)(gen->next() >> 1));
+             break;
+         case 1:
+             if (randomBound(vm, vm.trans.num1))
+                 vm.trans.ret = garnishObject(vm.reader, (long)gen->nextBelow(vm.trans.num1.asSmallInt()));
+             break;
+         case 2:
+             vm.trans.ret = garnishObject(vm.reader, Number(gen->nextDouble()));
+             break;
+         }
+     });
+     for (long mode : { 0L, 2L }) {
+         const char* name = (mode == 0) ? "randomNext#" : "randomFloat#";
+         sys->put(Symbols::get()[name],
+                  defineMethod(unit, global, method,
+                               asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                       makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                       makeAssemblerLine(Instr::RTRV),
+                                       makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                       makeAssemblerLine(Instr::INT, mode),
+                                       makeAssemblerLine(Instr::CPP, CPP_RANDOM_NEXT))));
+     }
+     sys->put(Symbols::get()["randomBelow#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::NUM1),
+                                   makeAssemblerLine(Instr::THROA, "Number expected"),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::INT, 1),
+                                   makeAssemblerLine(Instr::CPP, CPP_RANDOM_NEXT))));
+
+     // CPP_RANDOM_FILL (store an array of %num1 values from the pseudorandom generator %slf in %ret)
+     // If %ret is a number, the values are integers below it, as by
+     // randomBelow#. If %ret is Nil, they are floating point numbers, as
+     // by randomFloat#.
+     // randomFill#: gen, count, bound.
+     assert(reader.cpp.size() == CPP_RANDOM_FILL);
+     reader.cpp.push_back([](VMState& vm) {
+         RandomGenerator* gen = randomGenerator(vm);
+         if (gen == nullptr)
+             return;
+         if ((vm.trans.num1.hierarchyLevel() != 0) || (vm.trans.num1.asSmallInt() < 0)) {
+             throwError(vm, "ArgError", "Count must be a nonnegative integer");
+             return;
+         }
+         long count = vm.trans.num1.asSmallInt();
+         auto bound = boost::get<Number>(&vm.trans.ret->prim());
+         if (bound != nullptr) {
+             if (!randomBound(vm, *bound))
+                 return;
+         } else if (boost::get<boost::blank>(&vm.trans.ret->prim()) == nullptr) {
+             throwError(vm, "TypeError", "Number expected");
+             return;
+         }
+         ObjectPtr arr = clone(vm.reader.lit.at(Lit::ARRAY));
+         ArrayStore values;
+         for (long i = 0; i < count; i++) {
+             if (bound != nullptr)
+                 values.elements().push_back(garnishObject(vm.reader, (long)gen->nextBelow(bound->asSmallInt())));
+             else
+                 values.elements().push_back(garnishObject(vm.reader, Number(gen->nextDouble())));
+         }
+         arr->prim() = std::move(values);
+         vm.trans.ret = arr;
+     });
+     sys->put(Symbols::get()["randomFill#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$3"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::POP, Reg::PTR, Reg::STO),
+                                   makeAssemblerLine(Instr::ECLR),
+                                   makeAssemblerLine(Instr::EXPD, Reg::NUM1),
+                                   makeAssemblerLine(Instr::THROA, "Number expected"),
+                                   makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_RANDOM_FILL))));
+
+     // CPP_CLOCK (put the reading of a clock, in nanoseconds, into %ret, based on the value of %num0)
+     //  * 0 - A monotonic clock, whose readings are only meaningful relative to one another
+     //  * 1 - The processor time used by the interpreter
+     // monotonicNanos#.
+     // cpuTimeNanos#.
+     assert(reader.cpp.size() == CPP_CLOCK);
+     reader.cpp.push_back([](VMState& vm) {
+         long value = (vm.trans.num0.asSmallInt() == 0) ? monotonicNanos() : cpuTimeNanos();
+         vm.trans.ret = garnishObject(vm.reader, value);
+     });
+     sys->put(Symbols::get()["monotonicNanos#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::INT, 0L),
+                                   makeAssemblerLine(Instr::CPP, CPP_CLOCK))));
+     sys->put(Symbols::get()["cpuTimeNanos#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::INT, 1L),
+                                   makeAssemblerLine(Instr::CPP, CPP_CLOCK))));
+
+     // CPP_DICT_VISIT (call the block on each entry of the dictionary, in insertion order)
+     // The %sto stack holds the dictionary, a snapshot array of its keys
+     // (Nil initially), the prototype for the cons cells, the block, and
+     // the index of the next key (Nil initially). The keys are taken
+     // once, at the start, so keys added during the iteration are not
+     // visited, but each value is looked up afresh, so keys removed in
+     // the meantime are skipped. The block is called with a clone of
+     // the prototype whose car is the key, whose cdr is the value, and
+     // whose dict is the dictionary.
+     // When the iteration finishes, the five values are popped and the
+     // dictionary is stored in %ret.
+     // dictVisit#: dict, block, cons.
+     assert(reader.cpp.size() == CPP_DICT_VISIT);
+     reader.cpp.push_back([](VMState& vm) {
+             ObjectPtr cursor = vm.state.sto.top();
+             vm.state.sto.pop();
+             ObjectPtr block = vm.state.sto.top();
+             vm.state.sto.pop();
+             ObjectPtr proto = vm.state.sto.top();
+             vm.state.sto.pop();
+             ObjectPtr keys = vm.state.sto.top();
+             vm.state.sto.pop();
+             ObjectPtr dict = vm.state.sto.top();
+             auto store = boost::get<DictStore>(&dict->prim());
+             if (store == nullptr) {
+                 vm.state.sto.pop();
+                 throwError(vm, "TypeError", "Dict expected");
+                 return;
+             }
+             auto keyStore = boost::get<ArrayStore>(&keys->prim());
+             if (keyStore == nullptr) {
+                 keys = clone(vm.reader.lit.at(Lit::ARRAY));
+                 ArrayStore keys0;
+                 std::vector<ObjectPtr> keys1 = store->keys();
+                 keys0.elements().assign(keys1.begin(), keys1.end());
+                 keys->prim() = std::move(keys0);
+                 keyStore = boost::get<ArrayStore>(&keys->prim());
+             }
+             const auto& elements = static_cast<const ArrayStore*>(keyStore)->elements();
+             auto index0 = boost::get<Number>(&cursor->prim());
+             std::size_t index = (index0 != nullptr) ? index0->asSmallInt() : 0;
+             ObjectPtr key, value;
+             while ((value == nullptr) && (index < elements.size())) {
+                 key = elements[index++];
+                 value = store->get(key);
+             }
+             if (value == nullptr) {
+                 vm.state.sto.pop();
+                 vm.trans.ret = dict;
+                 return;
+             }
+             ObjectPtr pair = clone(proto);
+             pair->put(Symbols::get()["carCell"], key);
+             pair->put(Symbols::get()["cdrCell"], value);
+             pair->put(Symbols::get()["dict"], dict);
+             vm.state.sto.push(keys);
+             vm.state.sto.push(proto);
+             vm.state.sto.push(block);
+             vm.state.sto.push(garnishObject(vm.reader, (long)index));
+             visitElement(vm, block, pair, GTU_DICT_VISIT);
+         });
+     sys->put(Symbols::get()["dictVisit#"],
+              defineMethod(unit, global, method,
+                           asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$1"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::YLD, Lit::NIL, Reg::RET),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$3"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::GETD, Reg::SLF),
+                                   makeAssemblerLine(Instr::SYMN, Symbols::get()["$2"].index),
+                                   makeAssemblerLine(Instr::RTRV),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::YLD, Lit::NIL, Reg::RET),
+                                   makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                                   makeAssemblerLine(Instr::CPP, CPP_DICT_VISIT))));
+
+     // GTU METHODS //
+
+     // These methods MUST be pushed in the correct order or the standard library
+     // code will fail spectacularly. The assertions here verify that that is the
+     // case.
+
+     FunctionIndex temp;
+
+     // GTU_EMPTY
+     reader.gtu->method(0) = asmCode();
+
+     // GTU_LOOP_DO
+     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::PUSH, Reg::PTR, Reg::STO),
+                                           makeAssemblerLine(Instr::MOV, Reg::PTR, Reg::SLF),
+                                           makeAssemblerLine(Instr::CALL, 0L),
+                                           makeAssemblerLine(Instr::POP, Reg::PTR, Reg::STO),
+                                           makeAssemblerLine(Instr::CPP, CPP_LOOP_DO)));
+     assert(temp.index == GTU_LOOP_DO);
+
+     // GTU_RETURN
+     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::RET)));
+     assert(temp.index == GTU_RETURN);
+
+     // GTU_THROW
+     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::THROW)));
+     assert(temp.index == GTU_THROW);
+
+     // GTU_TERMINATE
+     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::CPP, CPP_TERMINATE)));
+     assert(temp.index == GTU_TERMINATE);
+
+     // GTU_HANDLER
+     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::POP, Reg::SLF, Reg::HAND),
+                                           makeAssemblerLine(Instr::PEEK, Reg::SLF, Reg::ARG),
+                                           makeAssemblerLine(Instr::POP, Reg::PTR, Reg::STO),
+                                           makeAssemblerLine(Instr::CALL, 1L)));
+     assert(temp.index == GTU_HANDLER);
+
+     // GTU_CALL_ONE
+     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::CALL, 1L)));
+     assert(temp.index == GTU_CALL_ONE);
 
      // GTU_CALL_ZERO
      temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::CALL, 0L)));
@@ -2801,6 +4597,30 @@ void spawnSystemCallsNew(ObjectPtr global,
      temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::POP, Reg::RET, Reg::STO)));
      assert(temp.index == GTU_UNSTORED);
 
+     // GTU_ARRAY_VISIT
+     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::ARG),
+                                           makeAssemblerLine(Instr::CALL, 1L),
+                                           makeAssemblerLine(Instr::CPP, CPP_ARRAY_VISIT)));
+     assert(temp.index == GTU_ARRAY_VISIT);
+
+     // GTU_RANGE_VISIT
+     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::ARG),
+                                           makeAssemblerLine(Instr::CALL, 1L),
+                                           makeAssemblerLine(Instr::CPP, CPP_RANGE_VISIT)));
+     assert(temp.index == GTU_RANGE_VISIT);
+
+     // GTU_DICT_VISIT
+     temp = reader.gtu->pushMethod(asmCode(makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::ARG),
+                                           makeAssemblerLine(Instr::CALL, 1L),
+                                           makeAssemblerLine(Instr::CPP, CPP_DICT_VISIT)));
+     assert(temp.index == GTU_DICT_VISIT);
+
+     // Superinstructions for the hand-assembled code
+     if (optimize::getLevel() != optimize::Level::NONE) {
+         optimize::fuseInstructions(unit);
+         optimize::fuseInstructions(reader.gtu);
+     }
+
 }
 
 void bindArgv(ObjectPtr argv_, ObjectPtr string, int argc, char** argv) {
@@ -2838,6 +4658,7 @@ ObjectPtr spawnObjects(IntState& state, ReadOnlyState& reader, int argc, char**
 
     ObjectPtr array_(clone(object));
     ObjectPtr dict(clone(object));
+    ObjectPtr bytes(clone(object));
 
     ObjectPtr sys(clone(object));
     ObjectPtr stackFrame(clone(object));
@@ -2850,7 +4671,6 @@ ObjectPtr spawnObjects(IntState& state, ReadOnlyState& reader, int argc, char**
     ObjectPtr false_(clone(boolean));
 
     ObjectPtr argv_(clone(object));
-    ObjectPtr fresh(clone(object));
 
     // Global calls for basic types
     global->put(Symbols::get()["Object"], object);
@@ -2870,6 +4690,7 @@ ObjectPtr spawnObjects(IntState& state, ReadOnlyState& reader, int argc, char**
     global->put(Symbols::get()["SystemError"], systemError);
     global->put(Symbols::get()["Array"], array_);
     global->put(Symbols::get()["Dict"], dict);
+    global->put(Symbols::get()["ByteBuffer"], bytes);
     global->put(Symbols::get()["Kernel"], kernel);
     global->put(Symbols::get()["StackFrame"], stackFrame);
     global->put(Symbols::get()["FileHeader"], fileHeader);
@@ -2913,6 +4734,9 @@ ObjectPtr spawnObjects(IntState& state, ReadOnlyState& reader, int argc, char**
     number->prim(0.0);
     string->prim("");
     symbol->prim(Symbols::get()[""]);
+    array_->prim(ArrayStore());
+    dict->prim(DictStore());
+    bytes->prim(ByteBuffer());
     stdout_->prim(outStream());
     stdin_->prim(inStream());
     stderr_->prim(errStream());
@@ -2921,10 +4745,6 @@ ObjectPtr spawnObjects(IntState& state, ReadOnlyState& reader, int argc, char**
     global->put(Symbols::get()["$argv"], argv_);
     bindArgv(argv_, string, argc, argv);
 
-    // Dictionary setup
-    fresh->remove(Symbols::parent());
-    dict->put(Symbols::get()["&impl"], fresh);
-
     // Spawn the literal objects table
     assert(reader.lit.size() == Lit::NIL   );
     reader.lit.emplace_back(nil       );
@@ -2954,6 +4774,8 @@ ObjectPtr spawnObjects(IntState& state, ReadOnlyState& reader, int argc, char**
     reader.lit.emplace_back(dict      );
     assert(reader.lit.size() == Lit::OBJECT);
     reader.lit.emplace_back(object    );
+    assert(reader.lit.size() == Lit::BYTES );
+    reader.lit.emplace_back(bytes     );
 
     // The core libraries (this is done in runREPL now)
     //readFile("std/latitude.lat", { global, global }, state);
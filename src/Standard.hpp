@@ -72,7 +72,50 @@ namespace Table {
         CPP_WHILE_REGS_ZERO = 58,
         CPP_FRESH = 59,
         CPP_DUMPDBG = 60,
-        CPP_LATVER = 61;
+        CPP_LATVER = 61,
+        CPP_SAMPLE_PROF = 62,
+        CPP_ALLOC_PROF = 63,
+        CPP_GC_STATS = 64,
+        CPP_ARRAY_NTH = 65,
+        CPP_ARRAY_PUT = 66,
+        CPP_ARRAY_PUSH = 67,
+        CPP_ARRAY_POP = 68,
+        CPP_ARRAY_SIZE = 69,
+        CPP_DICT_GET = 70,
+        CPP_DICT_PUT = 71,
+        CPP_DICT_HAS = 72,
+        CPP_DICT_DELETE = 73,
+        CPP_DICT_SIZE = 74,
+        CPP_DICT_KEYS = 75,
+        CPP_ARRAY_VISIT = 76,
+        CPP_RANGE_VISIT = 77,
+        CPP_PROCESS_ARGS = 78,
+        CPP_STREAM_READY = 79,
+        CPP_STREAM_READ_AVAIL = 80,
+        CPP_STREAM_POLL = 81,
+        CPP_STREAM_READ_ALL = 82,
+        CPP_STREAM_LINE = 83,
+        CPP_STREAM_READ_BYTES = 84,
+        CPP_STREAM_WRITE_BYTES = 85,
+        CPP_BYTES_SIZE = 86,
+        CPP_BYTES_NTH = 87,
+        CPP_BYTES_SLICE = 88,
+        CPP_BYTES_CONCAT = 89,
+        CPP_BYTES_DECODE = 90,
+        CPP_BYTES_FROM = 91,
+        CPP_BYTES_TO_STRING = 92,
+        CPP_STRING_CHAR_LENGTH = 93,
+        CPP_STRING_OFFSET = 94,
+        CPP_STRING_SUB_CHARS = 95,
+        CPP_STRING_SCAN = 96,
+        CPP_STRING_REPLACE_ALL = 97,
+        CPP_STRING_CASE = 98,
+        CPP_STRING_CATEGORY_SPAN = 99,
+        CPP_RANDOM_SEED = 100,
+        CPP_RANDOM_NEXT = 101,
+        CPP_RANDOM_FILL = 102,
+        CPP_CLOCK = 103,
+        CPP_DICT_VISIT = 104;
     constexpr long
         GTU_EMPTY = 0,
         GTU_LOOP_DO = 1,
@@ -96,7 +139,10 @@ namespace Table {
         GTU_POP_TWO = 19,
         GTU_WHILE_AGAIN = 20,
         GTU_STORED = 21,
-        GTU_UNSTORED = 22;
+        GTU_UNSTORED = 22,
+        GTU_ARRAY_VISIT = 23,
+        GTU_RANGE_VISIT = 24,
+        GTU_DICT_VISIT = 25;
 
 }
 
@@ -1,11 +1,18 @@
 //// Copyright (c) 2018 Silvio Mayolo
 //// See LICENSE.txt for licensing details
 
-// I need to guarantee the destruction order of these two singletons,
-// so I'm placing them in a separate translation unit together.
+// I need to guarantee the destruction order of these singletons, so
+// I'm placing them in a separate translation unit together. The
+// allocation profiler must outlive the GC, which reports frees to it,
+// and the string index cache must outlive the allocator, which
+// evicts freed objects from it.
 
 #include "GC.hpp"
 #include "Allocator.hpp"
+#include "Profiler.hpp"
+#include "Unicode.hpp"
 
+Utf8IndexCache Utf8IndexCache::instance;
+AllocationProfiler AllocationProfiler::instance;
 GC GC::instance = GC();
 Allocator Allocator::instance = Allocator();
@@ -2,34 +2,18 @@
 //// See LICENSE.txt for licensing details
 
 #include <fstream>
+#include <algorithm>
+#include <cstring>
 #include "Stream.hpp"
+#include "Platform.hpp"
 
-using namespace std;
+#ifdef USE_POSIX
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#endif
 
-class InFileStream : public Stream {
-private:
-    ifstream stream;
-public:
-    InFileStream(string name, FileMode mode);
-    ~InFileStream();
-    virtual bool hasIn() const noexcept;
-    virtual char in();
-    virtual std::string readLine();
-    virtual bool isEof() const noexcept;
-};
-
-class OutFileStream : public Stream {
-private:
-    ofstream stream;
-public:
-    OutFileStream(string name, FileMode mode);
-    ~OutFileStream();
-    virtual bool hasOut() const noexcept;
-    virtual void out(char);
-    virtual void writeLine(std::string);
-    virtual bool isEof() const noexcept;
-    virtual void flush();
-};
+using namespace std;
 
 char Stream::in() {
     return 0;
@@ -37,6 +21,22 @@ char Stream::in() {
 
 void Stream::out(char ch) {}
 
+size_t Stream::read(char* buf, size_t n) {
+    size_t count = 0;
+    while (count < n) {
+        char ch = in();
+        if (isEof())
+            break;
+        buf[count++] = ch;
+    }
+    return count;
+}
+
+void Stream::write(const char* buf, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out(buf[i]);
+}
+
 bool Stream::hasIn() const noexcept {
     return false;
 }
@@ -56,22 +56,37 @@ string Stream::readLine() {
 }
 
 string Stream::readText(int n) {
-    ostringstream out;
-    for (int i = 0; i < n; i++) {
-        char ch = in();
-        out << ch;
+    string result(n, '\0');
+    size_t count = 0;
+    while (count < result.size()) {
+        size_t curr = read(&result[count], result.size() - count);
+        if (curr == 0)
+            break;
+        count += curr;
     }
-    return out.str();
+    result.resize(count);
+    return result;
+}
+
+string Stream::readAll() {
+    string result;
+    char buf[4096];
+    while (size_t count = read(buf, sizeof(buf)))
+        result.append(buf, count);
+    return result;
 }
 
 void Stream::writeLine(string str) {
-    writeText(str);
-    out('\n');
+    str += '\n';
+    write(str.data(), str.size());
 }
 
 void Stream::writeText(string str) {
-    for (char ch : str)
-        out(ch);
+    write(str.data(), str.size());
+}
+
+bool Stream::isReady() {
+    return true;
 }
 
 bool Stream::isEof() const noexcept {
@@ -82,166 +97,287 @@ void Stream::close() {}
 
 void Stream::flush() {}
 
-bool CoutStream::hasOut() const noexcept {
-    return true;
-}
+constexpr size_t BufferedStream::BUFFER_SIZE;
 
-void CoutStream::out(char ch) {
-    cout << ch;
-}
+BufferedStream::BufferedStream()
+    : inBuf(), inPos(0), inEnd(0), outBuf(), eof(false) {}
 
-void CoutStream::writeLine(string str) {
-    cout << str << endl;
+bool BufferedStream::fill() {
+    if (inBuf.empty())
+        inBuf.resize(BUFFER_SIZE);
+    inPos = 0;
+    inEnd = readRaw(inBuf.data(), inBuf.size());
+    if (inEnd == 0)
+        eof = true;
+    return inEnd > 0;
 }
 
-bool CoutStream::isEof() const noexcept {
-    return cout.eof();
+char BufferedStream::in() {
+    if ((inPos == inEnd) && (!fill()))
+        return char_traits<char>::eof();
+    return inBuf[inPos++];
 }
 
-void CoutStream::flush() {
-    cout.flush();
+void BufferedStream::out(char ch) {
+    outBuf += ch;
+    if (outBuf.size() >= BUFFER_SIZE)
+        flush();
 }
 
-bool CerrStream::hasOut() const noexcept {
-    return true;
+size_t BufferedStream::read(char* buf, size_t n) {
+    if (inPos == inEnd) {
+        // Large reads bypass the buffer entirely.
+        if (n >= BUFFER_SIZE) {
+            size_t count = readRaw(buf, n);
+            if (count == 0)
+                eof = true;
+            return count;
+        }
+        if (!fill())
+            return 0;
+    }
+    size_t count = min(n, inEnd - inPos);
+    memcpy(buf, &inBuf[inPos], count);
+    inPos += count;
+    return count;
 }
 
-void CerrStream::out(char ch) {
-    cerr << ch;
+void BufferedStream::write(const char* buf, size_t n) {
+    if (outBuf.size() + n > BUFFER_SIZE)
+        flush();
+    if (n >= BUFFER_SIZE)
+        writeRaw(buf, n);
+    else
+        outBuf.append(buf, n);
 }
 
-void CerrStream::writeLine(string str) {
-    cerr << str << endl;
+string BufferedStream::readLine() {
+    string result;
+    while ((inPos < inEnd) || fill()) {
+        const char* start = &inBuf[inPos];
+        const char* end = static_cast<const char*>(memchr(start, '\n', inEnd - inPos));
+        if (end != nullptr) {
+            result.append(start, end);
+            inPos += (end - start) + 1;
+            return result;
+        }
+        result.append(start, inEnd - inPos);
+        inPos = inEnd;
+    }
+    return result;
 }
 
-bool CerrStream::isEof() const noexcept {
-    return cerr.eof();
+string BufferedStream::readAll() {
+    string result;
+    if (inPos < inEnd)
+        result.assign(&inBuf[inPos], inEnd - inPos);
+    inPos = inEnd;
+    // Read straight into the result, all at once if the size of the
+    // source is known. The first chunk has room for one byte past the
+    // expected size, so that reading the whole source comes up short.
+    size_t chunk = max(sizeHint() + 1, BUFFER_SIZE);
+    while (true) {
+        size_t count = result.size();
+        result.resize(count + chunk);
+        size_t curr = readRaw(&result[count], chunk);
+        result.resize(count + curr);
+        if (curr == 0)
+            break;
+        if (curr < chunk) {
+            // Check for the end of the source before growing the
+            // result, which would copy everything read so far.
+            char probe[256];
+            size_t extra = readRaw(probe, sizeof(probe));
+            if (extra == 0)
+                break;
+            result.append(probe, extra);
+        }
+        chunk = BUFFER_SIZE;
+    }
+    eof = true;
+    return result;
 }
 
-void CerrStream::flush() {
-    cerr.flush();
+size_t BufferedStream::sizeHint() {
+    return 0;
 }
 
-bool CinStream::hasIn() const noexcept {
+bool BufferedStream::rawReady() {
     return true;
 }
 
-char CinStream::in() {
-    return cin.get();
+bool BufferedStream::isReady() {
+    return (inPos < inEnd) || eof || rawReady();
 }
 
-string CinStream::readLine() {
-    string result;
-    getline(cin, result);
-    return result;
+bool BufferedStream::isEof() const noexcept {
+    return eof;
 }
 
-bool CinStream::isEof() const noexcept {
-    return cin.eof();
+void BufferedStream::flush() {
+    if (!outBuf.empty()) {
+        writeRaw(outBuf.data(), outBuf.size());
+        outBuf.clear();
+    }
 }
 
-FileStream::FileStream(string name, FileAccess access, FileMode mode)
-    : stream() {
-    switch (access) {
-    case FileAccess::READ:
-        stream = unique_ptr<Stream>(new InFileStream(name, mode));
-        break;
-    case FileAccess::WRITE:
-        stream = unique_ptr<Stream>(new OutFileStream(name, mode));
-        break;
-    }
+bool CoutStream::hasOut() const noexcept {
+    return true;
 }
 
-bool FileStream::hasOut() const noexcept {
-    return stream->hasOut();
+void CoutStream::out(char ch) {
+    cout << ch;
 }
 
-bool FileStream::hasIn() const noexcept {
-    return stream->hasIn();
+void CoutStream::write(const char* buf, size_t n) {
+    cout.write(buf, n);
 }
 
-void FileStream::out(char ch) {
-    return stream->out(ch);
+void CoutStream::writeLine(string str) {
+    cout << str << endl;
 }
 
-char FileStream::in() {
-    return stream->in();
+bool CoutStream::isEof() const noexcept {
+    return cout.eof();
 }
 
-void FileStream::writeLine(string line) {
-    return stream->writeLine(line);
+void CoutStream::flush() {
+    cout.flush();
 }
 
-string FileStream::readLine() {
-    return stream->readLine();
+bool CerrStream::hasOut() const noexcept {
+    return true;
 }
 
-bool FileStream::isEof() const noexcept {
-    return stream->isEof();
+void CerrStream::out(char ch) {
+    cerr << ch;
 }
 
-void FileStream::close() {
-    stream = unique_ptr<Stream>(new NullStream());
+void CerrStream::write(const char* buf, size_t n) {
+    cerr.write(buf, n);
 }
 
-void FileStream::flush() {
-    stream->flush();
+void CerrStream::writeLine(string str) {
+    cerr << str << endl;
 }
 
-InFileStream::InFileStream(string name, FileMode mode)
-    : stream(name, translateMode(mode)) {
-    stream.exceptions( ios_base::badbit );
+bool CerrStream::isEof() const noexcept {
+    return cerr.eof();
 }
 
-InFileStream::~InFileStream() {
-    stream.close();
+void CerrStream::flush() {
+    cerr.flush();
 }
 
-bool InFileStream::hasIn() const noexcept {
+bool CinStream::hasIn() const noexcept {
     return true;
 }
 
-char InFileStream::in() {
-    return stream.get();
+size_t CinStream::readRaw(char* buf, size_t n) {
+#ifdef USE_POSIX
+    ssize_t count;
+    do {
+        count = ::read(0, buf, n);
+    } while ((count < 0) && (errno == EINTR));
+    return (count < 0) ? 0 : count;
+#else
+    // Stop at the end of a line, so that console input is returned as
+    // soon as it has been entered.
+    size_t count = 0;
+    while (count < n) {
+        int ch = cin.get();
+        if (ch == char_traits<char>::eof())
+            break;
+        buf[count++] = (char)ch;
+        if (ch == '\n')
+            break;
+    }
+    return count;
+#endif
 }
 
-string InFileStream::readLine() {
-    string result;
-    getline(stream, result);
-    return result;
+void CinStream::writeRaw(const char* buf, size_t n) {}
+
+bool CinStream::rawReady() {
+#ifdef USE_POSIX
+    pollfd entry { 0, POLLIN, 0 };
+    return poll(&entry, 1, 0) != 0;
+#else
+    return true;
+#endif
 }
 
-bool InFileStream::isEof() const noexcept {
-    return stream.eof();
+FileStream::FileStream(string name, FileAccess access, FileMode mode)
+    : BufferedStream(), file(fopen(name.c_str(), translateMode(access, mode))), access(access) {
+    // BufferedStream does the buffering, so a second layer of
+    // buffering in the C library would only add a copy.
+    if (file != nullptr)
+        setvbuf(file, nullptr, _IONBF, 0);
+}
+
+FileStream::~FileStream() {
+    try {
+        close();
+    } catch (ios_base::failure&) {
+        // Nowhere to report the error from here
+    }
 }
 
-OutFileStream::OutFileStream(string name, FileMode mode)
-    : stream(name, translateMode(mode)) {
-    stream.exceptions( ios_base::badbit );
+size_t FileStream::readRaw(char* buf, size_t n) {
+    if (file == nullptr)
+        return 0;
+    size_t count = fread(buf, 1, n, file);
+    if ((count == 0) && (ferror(file)))
+        throw ios_base::failure("Error reading from file");
+    return count;
 }
 
-OutFileStream::~OutFileStream() {
-    stream.close();
+void FileStream::writeRaw(const char* buf, size_t n) {
+    if (file == nullptr)
+        return;
+    if (fwrite(buf, 1, n, file) < n)
+        throw ios_base::failure("Error writing to file");
 }
 
-bool OutFileStream::hasOut() const noexcept {
-    return true;
+size_t FileStream::sizeHint() {
+    if (file == nullptr)
+        return 0;
+    long pos = ftell(file);
+    if ((pos < 0) || (fseek(file, 0, SEEK_END) != 0))
+        return 0;
+    long end = ftell(file);
+    fseek(file, pos, SEEK_SET);
+    return (end > pos) ? end - pos : 0;
 }
 
-void OutFileStream::out(char ch) {
-    stream << ch;
+bool FileStream::hasOut() const noexcept {
+    return (file != nullptr) && (access == FileAccess::WRITE);
 }
 
-void OutFileStream::writeLine(string str) {
-    stream << str << endl;
+bool FileStream::hasIn() const noexcept {
+    return (file != nullptr) && (access == FileAccess::READ);
 }
 
-bool OutFileStream::isEof() const noexcept {
-    return stream.eof();
+bool FileStream::isEof() const noexcept {
+    if (file == nullptr)
+        return true;
+    return (access == FileAccess::READ) && BufferedStream::isEof();
 }
 
-void OutFileStream::flush() {
-    stream.flush();
+void FileStream::close() {
+    if (file != nullptr) {
+        std::FILE* curr = file;
+        try {
+            if (access == FileAccess::WRITE)
+                flush();
+        } catch (ios_base::failure&) {
+            file = nullptr;
+            fclose(curr);
+            throw;
+        }
+        file = nullptr;
+        fclose(curr);
+    }
 }
 
 ios_base::openmode translateMode(FileMode fmode) {
@@ -254,12 +390,23 @@ ios_base::openmode translateMode(FileMode fmode) {
     return {}; // -Wreturn-type asked nicely
 }
 
+const char* translateMode(FileAccess access, FileMode fmode) {
+    switch (access) {
+    case FileAccess::READ:
+        return (fmode == FileMode::BINARY) ? "rb" : "r";
+    case FileAccess::WRITE:
+        return (fmode == FileMode::BINARY) ? "wb" : "w";
+    }
+    return "r"; // -Wreturn-type asked nicely
+}
+
 StreamPtr outStream() {
     return StreamPtr(new CoutStream());
 }
 
 StreamPtr inStream() {
-    return StreamPtr(new CinStream());
+    static StreamPtr instance { new CinStream() };
+    return instance;
 }
 
 StreamPtr errStream() {
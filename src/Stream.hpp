@@ -8,6 +8,8 @@
 #include <sstream>
 #include <memory>
 #include <string>
+#include <vector>
+#include <cstdio>
 #include <ios>
 
 /// \file
@@ -48,6 +50,25 @@ public:
     /// \param ch the character to write
     virtual void out(char ch);
 
+    /// Reads up to n characters from the stream into a buffer. The
+    /// stream must have been designated for input. Fewer than n
+    /// characters may be read if fewer are immediately available, but
+    /// zero characters are read only at the end of the stream. By
+    /// default, this method is implemented in terms of Stream::in.
+    ///
+    /// \param buf the buffer, which must hold at least n characters
+    /// \param n the maximum number of characters to read
+    /// \return the number of characters read
+    virtual std::size_t read(char* buf, std::size_t n);
+
+    /// Writes n characters from a buffer to the stream. The stream
+    /// must have been designated for output. By default, this method
+    /// is implemented in terms of Stream::out.
+    ///
+    /// \param buf the buffer
+    /// \param n the number of characters to write
+    virtual void write(const char* buf, std::size_t n);
+
     /// \return whether the stream is designated for input.
     virtual bool hasIn() const noexcept;
 
@@ -69,6 +90,13 @@ public:
     /// \return the data
     virtual std::string readText(int n);
 
+    /// Reads all of the remaining input from the stream. The stream
+    /// must have been designated for input, and it will be at its end
+    /// afterward.
+    ///
+    /// \return the data
+    virtual std::string readAll();
+
     /// Writes a line of text to the stream, followed by '\\n'. The
     /// stream must have been designated for output.
     ///
@@ -81,6 +109,14 @@ public:
     /// \param str the string
     virtual void writeText(std::string str);
 
+    /// Returns whether a read from the stream would return without
+    /// blocking, either because input is already available or
+    /// because the stream is at its end. Streams which cannot tell
+    /// are always considered ready, which is the default.
+    ///
+    /// \return whether the stream is ready for reading
+    virtual bool isReady();
+
     /// Returns whether the stream is at its end. Any nontrivial
     /// subclass of Stream should override this method, as the default
     /// implementation simply always returns true.
@@ -96,6 +132,81 @@ public:
     virtual void flush();
 };
 
+/// A stream which reads and writes through user-space buffers, so
+/// that the underlying source or sink is accessed in large blocks
+/// rather than one character at a time. Subclasses provide the
+/// unbuffered transfers by overriding BufferedStream::readRaw and
+/// BufferedStream::writeRaw. Any subclass which writes should call
+/// BufferedStream::flush before releasing its sink, since buffered
+/// output cannot be flushed from the BufferedStream destructor.
+class BufferedStream : public Stream {
+private:
+    std::vector<char> inBuf;
+    std::size_t inPos;
+    std::size_t inEnd;
+    std::string outBuf;
+    bool eof;
+
+    /// Refills the (empty) input buffer.
+    ///
+    /// \return whether any characters were read
+    bool fill();
+
+protected:
+
+    /// Reads up to n characters directly from the underlying source,
+    /// returning zero only at the end of the source.
+    ///
+    /// \param buf the buffer
+    /// \param n the maximum number of characters to read
+    /// \return the number of characters read
+    virtual std::size_t readRaw(char* buf, std::size_t n) = 0;
+
+    /// Writes all n characters directly to the underlying sink.
+    ///
+    /// \param buf the buffer
+    /// \param n the number of characters to write
+    virtual void writeRaw(const char* buf, std::size_t n) = 0;
+
+    /// Returns whether BufferedStream::readRaw would return without
+    /// blocking. By default, the source is assumed never to block.
+    ///
+    /// \return whether the underlying source is ready
+    virtual bool rawReady();
+
+    /// Returns the number of characters remaining in the underlying
+    /// source, if it can be determined cheaply, so that
+    /// BufferedStream::readAll can read them all at once. The default
+    /// implementation returns zero, meaning unknown.
+    ///
+    /// \return the estimated number of remaining characters
+    virtual std::size_t sizeHint();
+
+public:
+
+    /// The size of each of the input and output buffers.
+    static constexpr std::size_t BUFFER_SIZE = 65536;
+
+    BufferedStream();
+    virtual char in();
+    virtual void out(char ch);
+    virtual std::size_t read(char* buf, std::size_t n);
+    virtual void write(const char* buf, std::size_t n);
+
+    /// Reads a full line of input from the stream. Unlike the
+    /// default Stream::readLine, a line is terminated only by '\\n'
+    /// or EOF, so a trailing '\\r' is left in place, as with
+    /// `std::getline`.
+    ///
+    /// \return the string, excluding the newline character
+    virtual std::string readLine();
+
+    virtual std::string readAll();
+    virtual bool isReady();
+    virtual bool isEof() const noexcept;
+    virtual void flush();
+};
+
 /// An empty stream that has neither read nor write priveleges. This
 /// is used to represent a file that has already been closed.
 class NullStream : public Stream {};
@@ -105,6 +216,7 @@ class CoutStream : public Stream {
 public:
     virtual bool hasOut() const noexcept;
     virtual void out(char);
+    virtual void write(const char*, std::size_t);
     virtual void writeLine(std::string);
     virtual bool isEof() const noexcept;
     virtual void flush();
@@ -115,25 +227,42 @@ class CerrStream : public Stream {
 public:
     virtual bool hasOut() const noexcept;
     virtual void out(char);
+    virtual void write(const char*, std::size_t);
     virtual void writeLine(std::string);
     virtual bool isEof() const noexcept;
     virtual void flush();
 };
 
-/// A stream that binds to `cin`. Input only.
-class CinStream : public Stream {
+/// A stream that reads from standard input. Input only. Input is
+/// buffered by BufferedStream rather than by the C library, so there
+/// must be only one such stream, which inStream returns. On POSIX
+/// systems, the stream reads file descriptor 0 directly, it is ready
+/// whenever a zero-timeout `poll` reports input, and each raw read is
+/// a single `read` call, which returns whatever input is available. On
+/// other systems, the stream reads from `cin` a line at a time and is
+/// always considered ready.
+class CinStream : public BufferedStream {
+protected:
+    virtual std::size_t readRaw(char* buf, std::size_t n);
+    virtual void writeRaw(const char* buf, std::size_t n);
+    virtual bool rawReady();
 public:
     virtual bool hasIn() const noexcept;
-    virtual char in();
-    virtual std::string readLine();
-    virtual bool isEof() const noexcept;
 };
 
 /// A stream that binds to a file. The input/output mode of the stream
-/// depends on how the file is opened.
-class FileStream : public Stream {
+/// depends on how the file is opened. The file is accessed through
+/// the buffers of BufferedStream, with the C library's own buffering
+/// disabled. If the file cannot be opened, the stream behaves as
+/// though it were already closed.
+class FileStream : public BufferedStream {
 private:
-    std::unique_ptr<Stream> stream;
+    std::FILE* file;
+    FileAccess access;
+protected:
+    virtual std::size_t readRaw(char* buf, std::size_t n);
+    virtual void writeRaw(const char* buf, std::size_t n);
+    virtual std::size_t sizeHint();
 public:
     /// Constructs a FileStream.
     ///
@@ -141,18 +270,23 @@ public:
     /// \param access whether the stream is for input or output
     /// \param mode whether the file contains text or binary data
     FileStream(std::string name, FileAccess access, FileMode mode);
-    virtual ~FileStream() = default;
+    FileStream(const FileStream&) = delete;
+    FileStream& operator=(const FileStream&) = delete;
+    virtual ~FileStream();
     virtual bool hasOut() const noexcept;
     virtual bool hasIn() const noexcept;
-    virtual void out(char);
-    virtual char in();
-    virtual void writeLine(std::string);
-    virtual std::string readLine();
     virtual bool isEof() const noexcept;
     virtual void close();
-    virtual void flush();
 };
 
+/// Converts a FileAccess and FileMode pair to the corresponding mode
+/// string for `std::fopen`.
+///
+/// \param access the file access
+/// \param fmode the file mode
+/// \return the mode string
+const char* translateMode(FileAccess access, FileMode fmode);
+
 /// Converts a FileMode value to the appropriate ios_base bitflag
 /// value. The returned value is appropriate for bitwise-or
 /// application to any other desired flags.
@@ -163,12 +297,16 @@ std::ios_base::openmode translateMode(FileMode fmode);
 
 // Functions for creating stream objects bound to the three default
 // streams. These are NOT accessors; they allocate a new object each
-// time they are called.
+// time they are called, except for inStream.
 
 /// \return a pointer to a cout stream.
 StreamPtr outStream();
 
-/// \return a pointer to a cin stream.
+/// Returns the standard input stream. Unlike the other two functions,
+/// this always returns the same stream, since input read ahead into
+/// the stream's buffer would be lost to any other reader.
+///
+/// \return a pointer to the cin stream.
 StreamPtr inStream();
 
 /// \return a pointer to a cerr stream.
@@ -4,6 +4,12 @@
 
 #include "Unicode.hpp"
 #include "pl_Unidata.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 UniChar::UniChar(long cp)
     : codepoint(cp) {}
@@ -60,7 +66,7 @@ UniChar uniChr(long cp) {
     return UniChar(cp);
 }
 
-boost::optional<UniChar> charAt(std::string str, long i) {
+boost::optional<UniChar> charAt(const std::string& str, long i) {
     if ((i < 0) || ((unsigned long)i >= str.length()))
         return boost::none;
     bool valid = true;
@@ -102,7 +108,7 @@ boost::optional<UniChar> charAt(std::string str, long i) {
         return boost::none;
 }
 
-boost::optional<long> nextCharPos(std::string str, long i) {
+boost::optional<long> nextCharPos(const std::string& str, long i) {
     if ((i < 0) || ((unsigned long)i >= str.length()))
         return boost::none;
     // Based on the algorithm at http://stackoverflow.com/a/4063258/2288659
@@ -134,3 +140,330 @@ boost::optional<long> nextCharPos(std::string str, long i) {
     else
         return boost::none;
 }
+
+namespace {
+
+    constexpr std::uint64_t HIGH_BITS = 0x8080808080808080ULL;
+
+    // Returns whether the eight bytes beginning at the pointer are
+    // all ASCII.
+    bool asciiWord(const char* ptr) {
+        std::uint64_t word;
+        std::memcpy(&word, ptr, sizeof(word));
+        return (word & HIGH_BITS) == 0;
+    }
+
+#ifdef __SSE2__
+    // Returns whether the sixteen bytes beginning at the pointer are
+    // all ASCII.
+    bool asciiBlock(const char* ptr) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+        return _mm_movemask_epi8(block) == 0;
+    }
+#endif
+
+    // Returns the number of bytes in the character beginning with
+    // the given byte, which must begin a valid character.
+    std::size_t charWidth(unsigned char c) {
+        if (c < 0x80)
+            return 1;
+        else if (c < 0xE0)
+            return 2;
+        else if (c < 0xF0)
+            return 3;
+        else
+            return 4;
+    }
+
+}
+
+constexpr std::size_t Utf8Index::STRIDE;
+
+Utf8Index::Utf8Index(const std::string& str)
+    : offsets(), chars(0), valid(true), ascii(true) {
+    const std::size_t size = str.size();
+    const char* data = str.data();
+    std::size_t pos = 0;
+#ifdef __SSE2__
+    while ((pos + 16 <= size) && asciiBlock(data + pos))
+        pos += 16;
+#endif
+    while ((pos + 8 <= size) && asciiWord(data + pos))
+        pos += 8;
+    while ((pos < size) && (static_cast<unsigned char>(data[pos]) < 0x80))
+        ++pos;
+    if (pos == size) {
+        chars = size;
+        return;
+    }
+    // The string is not pure ASCII, so walk it one character at a
+    // time from the last stride boundary before the first non-ASCII
+    // byte, recording an offset at each boundary.
+    ascii = false;
+    chars = pos - pos % STRIDE;
+    for (std::size_t i = 0; i < chars; i += STRIDE)
+        offsets.push_back(i);
+    pos = chars;
+    while (pos < size) {
+        if (chars % STRIDE == 0) {
+            offsets.push_back(pos);
+            // Skip a whole stride of ASCII at once where possible.
+            if ((pos + STRIDE <= size) &&
+                std::all_of(data + pos, data + pos + STRIDE,
+                            [](char c) { return static_cast<unsigned char>(c) < 0x80; })) {
+                pos += STRIDE;
+                chars += STRIDE;
+                continue;
+            }
+        }
+        auto next = nextCharPos(str, pos);
+        if (!next) {
+            valid = false;
+            offsets.clear();
+            return;
+        }
+        pos = *next;
+        ++chars;
+    }
+}
+
+bool Utf8Index::isValid() const noexcept {
+    return valid;
+}
+
+bool Utf8Index::isAscii() const noexcept {
+    return ascii;
+}
+
+std::size_t Utf8Index::length() const noexcept {
+    return chars;
+}
+
+std::size_t Utf8Index::byteOffset(const std::string& str, std::size_t pos) const noexcept {
+    if (ascii)
+        return pos;
+    if (pos >= chars)
+        return str.size();
+    std::size_t offset = offsets[pos / STRIDE];
+    for (std::size_t i = pos % STRIDE; i > 0; i--)
+        offset += charWidth(static_cast<unsigned char>(str[offset]));
+    return offset;
+}
+
+std::size_t Utf8Index::charPos(const std::string& str, std::size_t offset) const noexcept {
+    if (ascii)
+        return offset;
+    auto iter = std::upper_bound(offsets.begin(), offsets.end(), offset);
+    std::size_t block = (iter - offsets.begin()) - 1;
+    std::size_t curr = offsets[block];
+    std::size_t pos = block * STRIDE;
+    while (curr < offset) {
+        curr += charWidth(static_cast<unsigned char>(str[curr]));
+        ++pos;
+    }
+    return pos;
+}
+
+Utf8IndexCache::Utf8IndexCache() noexcept : entries(), next(0) {}
+
+Utf8IndexCache& Utf8IndexCache::get() noexcept {
+    return instance;
+}
+
+std::shared_ptr<const Utf8Index> Utf8IndexCache::lookup(const void* owner, const std::string& str) {
+    for (Entry& entry : entries) {
+        if ((entry.owner == owner) && (entry.data == str.data()) && (entry.size == str.size()))
+            return entry.index;
+    }
+    forget(owner);
+    auto index = std::make_shared<const Utf8Index>(str);
+    entries[next] = { owner, str.data(), str.size(), index };
+    next = (next + 1) % SIZE;
+    return index;
+}
+
+std::vector<std::size_t> findAllBytes(const std::string& str, const std::string& substr, bool overlapping) {
+    std::vector<std::size_t> result;
+    const std::size_t width = substr.size();
+    if ((width == 0) || (width > str.size()))
+        return result;
+    const char* data = str.data();
+    const char* needle = substr.data();
+    const std::size_t last = str.size() - width;
+    // The position of the first byte at which a match may begin. In
+    // non-overlapping mode, this is the end of the previous match.
+    std::size_t next = 0;
+    auto check = [&](std::size_t i) {
+        if ((i >= next) && (std::memcmp(data + i, needle, width) == 0)) {
+            result.push_back(i);
+            next = overlapping ? i + 1 : i + width;
+        }
+    };
+#ifdef __SSE2__
+    // Compare sixteen candidate positions at once against the first
+    // and last bytes of the substring, and only compare the whole
+    // substring at the positions where both agree.
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i final = _mm_set1_epi8(needle[width - 1]);
+    while (next + 16 <= last + 1) {
+        std::size_t block = next;
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + block));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + block + width - 1));
+        unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first),
+                                                            _mm_cmpeq_epi8(tail, final)));
+        unsigned int bit = 0;
+        while (mask != 0) {
+            while ((mask & (1u << bit)) == 0)
+                ++bit;
+            mask &= mask - 1;
+            check(block + bit);
+        }
+        next = std::max(next, block + 16);
+    }
+#endif
+    while (next <= last) {
+        const void* hit = std::memchr(data + next, needle[0], last - next + 1);
+        if (hit == nullptr)
+            break;
+        std::size_t i = static_cast<const char*>(hit) - data;
+        next = i;
+        check(i);
+        if (next == i)
+            ++next;
+    }
+    return result;
+}
+
+namespace {
+
+    // Converts an ASCII character to the given case.
+    char asciiCase(char c, LetterCase letterCase) {
+        if (letterCase == LetterCase::LOWER)
+            return ((c >= 'A') && (c <= 'Z')) ? c + ('a' - 'A') : c;
+        else
+            return ((c >= 'a') && (c <= 'z')) ? c - ('a' - 'A') : c;
+    }
+
+#ifdef __SSE2__
+    // Converts the ASCII letters among sixteen bytes to the given
+    // case. Bytes at or above 0x80 compare as negative, so they are
+    // never mistaken for letters and are left as they are.
+    __m128i asciiCaseBytes(__m128i block, LetterCase letterCase) {
+        char first = (letterCase == LetterCase::LOWER) ? 'A' : 'a';
+        __m128i above = _mm_cmpgt_epi8(block, _mm_set1_epi8(first - 1));
+        __m128i below = _mm_cmplt_epi8(block, _mm_set1_epi8(first + 26));
+        __m128i letters = _mm_and_si128(above, below);
+        return _mm_xor_si128(block, _mm_and_si128(letters, _mm_set1_epi8('a' - 'A')));
+    }
+
+    // Converts sixteen bytes to the given case, returning false
+    // without storing anything if any of them is not ASCII.
+    bool asciiCaseBlock(const char* src, char* dest, LetterCase letterCase) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        if (_mm_movemask_epi8(block) != 0)
+            return false;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), asciiCaseBytes(block, letterCase));
+        return true;
+    }
+#endif
+
+}
+
+boost::optional<std::string> convertCase(const std::string& str, LetterCase letterCase) {
+    const std::size_t size = str.size();
+    const char* data = str.data();
+    std::string result;
+    result.reserve(size);
+    std::size_t pos = 0;
+    while (pos < size) {
+#ifdef __SSE2__
+        char block[16];
+        if ((pos + 16 <= size) && asciiCaseBlock(data + pos, block, letterCase)) {
+            result.append(block, 16);
+            pos += 16;
+            continue;
+        }
+#endif
+        if (static_cast<unsigned char>(data[pos]) < 0x80) {
+            result += asciiCase(data[pos], letterCase);
+            ++pos;
+            continue;
+        }
+        auto ch = charAt(str, pos);
+        if (!ch)
+            return boost::none;
+        switch (letterCase) {
+        case LetterCase::LOWER:
+            result += static_cast<std::string>(ch->toLower());
+            break;
+        case LetterCase::UPPER:
+            result += static_cast<std::string>(ch->toUpper());
+            break;
+        case LetterCase::TITLE:
+            result += static_cast<std::string>(ch->toTitle());
+            break;
+        }
+        pos += charWidth(static_cast<unsigned char>(data[pos]));
+    }
+    return result;
+}
+
+std::string convertAsciiCase(const std::string& str, LetterCase letterCase) {
+    const std::size_t size = str.size();
+    std::string result(str);
+    std::size_t pos = 0;
+#ifdef __SSE2__
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&result[pos]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&result[pos]), asciiCaseBytes(block, letterCase));
+    }
+#endif
+    for (; pos < size; ++pos)
+        result[pos] = asciiCase(result[pos], letterCase);
+    return result;
+}
+
+boost::optional<std::size_t> categorySpan(const std::string& str, unsigned long categories) {
+    // Membership of each ASCII character in the set, one bit per
+    // character, so that ASCII text is classified without decoding.
+    std::uint64_t ascii[2] = { 0, 0 };
+    for (unsigned int c = 0; c < 0x80; c++) {
+        if (categories & (1UL << get_class(c)))
+            ascii[c >> 6] |= std::uint64_t(1) << (c & 63);
+    }
+    auto inSet = [&ascii](unsigned char c) {
+        return ((ascii[c >> 6] >> (c & 63)) & 1) != 0;
+    };
+    const std::size_t size = str.size();
+    const char* data = str.data();
+    std::size_t pos = 0;
+    std::size_t chars = 0;
+    while (pos < size) {
+#ifdef __SSE2__
+        if ((pos + 16 <= size) && asciiBlock(data + pos)) {
+            std::size_t i = 0;
+            while ((i < 16) && inSet(static_cast<unsigned char>(data[pos + i])))
+                ++i;
+            pos += i;
+            chars += i;
+            if (i < 16)
+                break;
+            continue;
+        }
+#endif
+        unsigned char c = static_cast<unsigned char>(data[pos]);
+        if (c < 0x80) {
+            if (!inSet(c))
+                break;
+        } else {
+            auto ch = charAt(str, pos);
+            if (!ch)
+                return boost::none;
+            if ((categories & (1UL << get_class(ch->codePoint()))) == 0)
+                break;
+        }
+        pos += charWidth(c);
+        ++chars;
+    }
+    return chars;
+}
@@ -5,7 +5,10 @@
 #define UNICODE_HPP
 
 #include "pl_Unidata.h"
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <vector>
 #include <boost/optional.hpp>
 
 /// \file
@@ -84,7 +87,7 @@ UniChar uniChr(long cp);
 /// \param str the string
 /// \param i the index
 /// \return the character, or an empty optional if out of bounds
-boost::optional<UniChar> charAt(std::string str, long i);
+boost::optional<UniChar> charAt(const std::string& str, long i);
 
 /// Returns the index of the next Unicode character after the
 /// character which starts at the nth byte. If the index is out of
@@ -96,6 +99,177 @@ boost::optional<UniChar> charAt(std::string str, long i);
 /// \param str the string
 /// \param i the index
 /// \return the next index, or an empty optional
-boost::optional<long> nextCharPos(std::string str, long i);
+boost::optional<long> nextCharPos(const std::string& str, long i);
+
+/// \brief A sparse index of the character positions in a UTF-8
+/// string.
+///
+/// The index records the byte offset of every #STRIDE-th character,
+/// so that converting between character positions and byte offsets
+/// never has to decode more than #STRIDE characters. A string which
+/// consists entirely of ASCII characters needs no offsets at all,
+/// since its character positions are its byte offsets. An index is
+/// only meaningful for the string from which it was built.
+class Utf8Index {
+private:
+    std::vector<std::size_t> offsets;
+    std::size_t chars;
+    bool valid;
+    bool ascii;
+public:
+
+    /// The number of characters between consecutive recorded
+    /// offsets.
+    static constexpr std::size_t STRIDE = 64;
+
+    /// Builds the index of a string. If the string is not valid
+    /// UTF-8, the index is marked invalid and cannot be used for
+    /// conversions.
+    ///
+    /// \param str the string
+    explicit Utf8Index(const std::string& str);
+
+    /// Returns whether the string is valid UTF-8.
+    ///
+    /// \return whether the string is valid
+    bool isValid() const noexcept;
+
+    /// Returns whether the string consists entirely of ASCII
+    /// characters.
+    ///
+    /// \return whether the string is ASCII
+    bool isAscii() const noexcept;
+
+    /// Returns the number of characters in the string.
+    ///
+    /// \return the length
+    std::size_t length() const noexcept;
+
+    /// Returns the byte offset at which a character begins. A
+    /// position equal to the length of the string gives the size of
+    /// the string in bytes. The string must be valid and the position
+    /// must not exceed its length.
+    ///
+    /// \param str the indexed string
+    /// \param pos the character position
+    /// \return the byte offset
+    std::size_t byteOffset(const std::string& str, std::size_t pos) const noexcept;
+
+    /// Returns the position of the first character which begins at
+    /// or after a byte offset. The string must be valid and the
+    /// offset must not exceed its size.
+    ///
+    /// \param str the indexed string
+    /// \param offset the byte offset
+    /// \return the character position
+    std::size_t charPos(const std::string& str, std::size_t offset) const noexcept;
+
+};
+
+/// \brief A small cache of the indices of recently used strings.
+///
+/// Each index is keyed by the owner of its string, which in practice
+/// is the object whose primitive field holds the string, and is
+/// rebuilt if the string's storage has visibly changed. Since that
+/// check cannot detect a string which has been replaced by another of
+/// the same size in the same storage, the owner must call #forget
+/// whenever its string is replaced or destroyed.
+class Utf8IndexCache {
+private:
+
+    struct Entry {
+        const void* owner;
+        const char* data;
+        std::size_t size;
+        std::shared_ptr<const Utf8Index> index;
+    };
+
+    static constexpr int SIZE = 4;
+
+    static Utf8IndexCache instance;
+
+    Entry entries[SIZE];
+    int next;
+
+    Utf8IndexCache() noexcept;
+
+public:
+
+    /// Returns the cache instance.
+    ///
+    /// \return the singleton instance
+    static Utf8IndexCache& get() noexcept;
+
+    /// Returns the index of a string, building it if it is not
+    /// already cached.
+    ///
+    /// \param owner the owner of the string
+    /// \param str the string
+    /// \return the index
+    std::shared_ptr<const Utf8Index> lookup(const void* owner, const std::string& str);
+
+    /// Discards the cached index belonging to an owner, if there is
+    /// one.
+    ///
+    /// \param owner the owner
+    void forget(const void* owner) noexcept {
+        for (Entry& entry : entries) {
+            if (entry.owner == owner)
+                entry = Entry();
+        }
+    }
+
+};
+
+/// Returns the byte offsets at which a substring occurs in a string,
+/// in increasing order. If \p overlapping is false, each match begins
+/// after the end of the previous one, as when splitting a string;
+/// otherwise, every occurrence is returned. Where SSE2 is available,
+/// the string is scanned sixteen bytes at a time. An empty substring
+/// never matches.
+///
+/// \param str the string to search
+/// \param substr the substring to find
+/// \param overlapping whether matches may overlap
+/// \return the offsets of the matches
+std::vector<std::size_t> findAllBytes(const std::string& str, const std::string& substr,
+                                      bool overlapping);
+
+/// The case conversions which can be applied to a whole string.
+enum class LetterCase { LOWER, UPPER, TITLE };
+
+/// Converts every character in a UTF-8 string to the given case, as
+/// by UniChar::toLower, UniChar::toUpper, or UniChar::toTitle. Runs
+/// of ASCII characters are converted without being decoded, sixteen
+/// bytes at a time where SSE2 is available. If the string is not
+/// valid UTF-8, an empty optional instance is returned.
+///
+/// \param str the string
+/// \param letterCase the case to convert to
+/// \return the converted string, or an empty optional
+boost::optional<std::string> convertCase(const std::string& str, LetterCase letterCase);
+
+/// Converts the ASCII letters in a string of bytes to the given case,
+/// treating title case as uppercase. All other bytes, including those
+/// which do not form valid UTF-8, are copied unchanged.
+///
+/// \param str the string
+/// \param letterCase the case to convert to
+/// \return the converted string
+std::string convertAsciiCase(const std::string& str, LetterCase letterCase);
+
+/// Returns the number of characters at the start of a UTF-8 string
+/// whose general categories all belong to a set. The set is a
+/// bitmask, in which the category \c cat is represented by the bit
+/// <tt>1 << cat</tt>. If an invalid character is encountered before
+/// the first character outside of the set, an empty optional instance
+/// is returned. Runs of ASCII text are classified sixteen bytes at a
+/// time against a table of the set's ASCII members, where SSE2 is
+/// available.
+///
+/// \param str the string
+/// \param categories the set of categories
+/// \return the number of characters, or an empty optional
+boost::optional<std::size_t> categorySpan(const std::string& str, unsigned long categories);
 
 #endif // UNICODE_HPP
@@ -14,6 +14,8 @@ extern "C" {
 #include "Pathname.hpp"
 #include "REPL.hpp"
 #include "Args.hpp"
+#include "Profiler.hpp"
+#include "Environment.hpp"
 #include <iostream>
 #include <cstring>
 #include <ctime>
@@ -23,6 +25,22 @@ int main(int argc, char** argv) {
     initRandom();
 
     CmdArgs args = parseArgs(argc, argv);
+    optimize::setLevel(args.level);
+
+    if (!args.instrProfile.empty()) {
+        InstrProfiler::get().start(args.instrProfile);
+    } else if (auto file = getEnv("LATITUDE_INSTR_PROFILE")) {
+        if (!file->empty())
+            InstrProfiler::get().start(*file);
+    }
+
+    if (!args.gcLog.empty())
+        GC::get().setStatsFile(args.gcLog);
+
+    if (!args.profile.empty()) {
+        if (!SamplingProfiler::get().start(args.profile))
+            std::cerr << "Sampling profiler not supported on this system" << std::endl;
+    }
 
     switch (args.output) {
     case OutputMode::NONE: {
@@ -42,6 +60,9 @@ int main(int argc, char** argv) {
     ObjectPtr global;
     VMState vm { VMState::createAndInit(&global, argc, argv) };
 
+    if (!args.allocProfile.empty())
+        AllocationProfiler::get().start(args.allocProfile, vm.state);
+
     switch (args.run) {
     case RunMode::REPL: {
         outputVersion();
@@ -62,9 +83,9 @@ int main(int argc, char** argv) {
     }
     }
 
-#ifdef PROFILE_INSTR
-    Profiling::get().dumpData();
-#endif
+    InstrProfiler::get().stop();
+    SamplingProfiler::get().stop();
+    AllocationProfiler::get().stop();
 
     return 0;
 }
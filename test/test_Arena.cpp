@@ -0,0 +1,35 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#include "catch2/catch.hpp"
+#include "test.hpp"
+#include "Arena.hpp"
+
+TEST_CASE( "Arena allocation", "" ) {
+
+  Arena arena;
+
+  SECTION( "Allocations are aligned and owned by the arena" ) {
+    void* a = arena.allocate(3, 1);
+    void* b = arena.allocate(sizeof(double), alignof(double));
+    REQUIRE( reinterpret_cast<uintptr_t>(b) % alignof(double) == 0 );
+    REQUIRE( arena.owns(a) );
+    REQUIRE( arena.owns(b) );
+    int local = 0;
+    REQUIRE( !arena.owns(&local) );
+  }
+
+  SECTION( "Large allocations get a block of their own" ) {
+    char* big = static_cast<char*>(arena.allocate(1000000));
+    big[999999] = 'x';
+    REQUIRE( arena.owns(big + 999999) );
+  }
+
+  SECTION( "Released memory is reused" ) {
+    void* first = arena.allocate(64);
+    arena.allocate(64);
+    arena.release();
+    REQUIRE( arena.allocate(64) == first );
+  }
+
+}
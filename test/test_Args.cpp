@@ -58,6 +58,40 @@ TEST_CASE( "parseArgs returns the appropriate values", "" ) {
     REQUIRE( result.output == OutputMode::NONE );
   }
 
+  SECTION( "--instr-profile" ) {
+    int argc = 3;
+    const char* argv[] { "EXE_NAME", "--instr-profile=out.tsv", "dummy_filename.lats" };
+    char** argv1 = const_cast<char**>(argv);
+
+    CmdArgs result = parseArgs(argc, argv1);
+    REQUIRE( argc == 2 );
+    REQUIRE( result.run == RunMode::RUNNER );
+    REQUIRE( result.instrProfile == "out.tsv" );
+  }
+
+  SECTION( "--profile" ) {
+    int argc = 3;
+    const char* argv[] { "EXE_NAME", "--profile=out.folded", "dummy_filename.lats" };
+    char** argv1 = const_cast<char**>(argv);
+
+    CmdArgs result = parseArgs(argc, argv1);
+    REQUIRE( argc == 2 );
+    REQUIRE( result.run == RunMode::RUNNER );
+    REQUIRE( result.profile == "out.folded" );
+    REQUIRE( result.instrProfile == "" );
+  }
+
+  SECTION( "--alloc-profile" ) {
+    int argc = 2;
+    const char* argv[] { "EXE_NAME", "--alloc-profile=allocs.tsv" };
+    char** argv1 = const_cast<char**>(argv);
+
+    CmdArgs result = parseArgs(argc, argv1);
+    REQUIRE( argc == 1 );
+    REQUIRE( result.run == RunMode::REPL );
+    REQUIRE( result.allocProfile == "allocs.tsv" );
+  }
+
   SECTION( "No arguments" ) {
     int argc = 1;
     const char* argv[] { "EXE_NAME" };
@@ -32,3 +32,81 @@ TEST_CASE( "The garbage collector cleans up cyclic references", "" ) {
   REQUIRE( !data->in_use );
 
 }
+
+TEST_CASE( "The garbage collector traces array elements", "" ) {
+
+  ObjectPtr arr = clone(globalVM->reader.lit[Lit::ARRAY]);
+  ObjectPtr elem = clone(globalVM->reader.lit[Lit::OBJECT]);
+  ObjectEntry* data = reinterpret_cast<ObjectEntry*>(elem.get());
+  boost::get<ArrayStore>(arr->prim()).elements().push_back(elem);
+  boost::get<ArrayStore>(arr->prim()).elements().push_back(arr);
+  elem = nullptr;
+
+  // The element is reachable through the array, so it survives
+  // collection as long as the array does.
+  globalVM->state.sto.push(arr);
+  GC::get().garbageCollect(*globalVM);
+  REQUIRE( data->in_use );
+  globalVM->state.sto.pop();
+
+  // The array refers to itself, so only the GC can free it.
+  arr = nullptr;
+  GC::get().garbageCollect(*globalVM);
+  REQUIRE( !data->in_use );
+
+}
+
+TEST_CASE( "The garbage collector traces dictionary entries", "" ) {
+
+  ObjectPtr dict = clone(globalVM->reader.lit[Lit::DICT]);
+  ObjectPtr key = clone(globalVM->reader.lit[Lit::OBJECT]);
+  ObjectPtr value = clone(globalVM->reader.lit[Lit::OBJECT]);
+  ObjectEntry* keyData = reinterpret_cast<ObjectEntry*>(key.get());
+  ObjectEntry* valueData = reinterpret_cast<ObjectEntry*>(value.get());
+  boost::get<DictStore>(dict->prim()).put(key, value);
+  boost::get<DictStore>(dict->prim()).put(value, dict);
+  key = nullptr;
+  value = nullptr;
+
+  // Both keys and values are reachable through the dictionary.
+  globalVM->state.sto.push(dict);
+  GC::get().garbageCollect(*globalVM);
+  REQUIRE( keyData->in_use );
+  REQUIRE( valueData->in_use );
+  globalVM->state.sto.pop();
+
+  // The dictionary refers to itself, so only the GC can free it.
+  dict = nullptr;
+  GC::get().garbageCollect(*globalVM);
+  REQUIRE( !keyData->in_use );
+  REQUIRE( !valueData->in_use );
+
+}
+
+TEST_CASE( "The garbage collector records statistics for each collection", "" ) {
+
+  unsigned long before = GC::get().getStats().collections;
+
+  ObjectPtr obj = clone(globalVM->reader.lit[Lit::OBJECT]);
+  obj->put(Symbols::get()["cyclicReference"], obj);
+  obj = nullptr;
+
+  long count = GC::get().garbageCollect(*globalVM);
+  const GCStats& stats = GC::get().getStats();
+  REQUIRE( stats.collections == before + 1 );
+  REQUIRE( stats.last.index == stats.collections );
+  REQUIRE( stats.last.freed == (size_t)count );
+  REQUIRE( stats.last.heapBefore == stats.last.heapAfter + stats.last.freed );
+  REQUIRE( stats.last.heapAfter == GC::get().getTotal() );
+  REQUIRE( stats.last.marked == stats.last.heapAfter );
+  REQUIRE( stats.maxPause >= stats.last.pause );
+  REQUIRE( stats.pausePercentile(0.99) >= stats.pausePercentile(0.5) );
+  REQUIRE( stats.last.allocator.used == GC::get().getTotal() );
+  REQUIRE( stats.last.allocator.used + stats.last.allocator.holes <= stats.last.allocator.capacity );
+
+  unsigned long recorded = 0;
+  for (unsigned long n : stats.pauseHistogram)
+    recorded += n;
+  REQUIRE( recorded == stats.collections );
+
+}
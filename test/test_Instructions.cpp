@@ -10,7 +10,7 @@ TEST_CASE( "InstructionSet behavior", "" ) {
 
   InstructionSet& iset = InstructionSet::getInstance();
 
-  for (unsigned char i = 0x01; i <= (unsigned char)Instr::MSWAP; i++) {
+  for (unsigned char i = 0x01; i <= (unsigned char)Instr::CALLR; i++) {
     REQUIRE( iset.hasInstruction((Instr)i) );
   }
 
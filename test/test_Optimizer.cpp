@@ -35,3 +35,212 @@ TEST_CASE( "lookupSymbols", "[optimize]" ) {
   REQUIRE( test->method(1)[3] == mov  );
 
 }
+
+TEST_CASE( "foldConstants", "[optimize]" ) {
+
+  InstrSeq seq = asmCode(makeAssemblerLine(Instr::NUM, "D42"),
+                         makeAssemblerLine(Instr::NUM, "X-1F"),
+                         makeAssemblerLine(Instr::NUM, "D100000000000000000000"),
+                         makeAssemblerLine(Instr::NUM, "D-9223372036854775808"),
+                         makeAssemblerLine(Instr::NUM, "D4294967295"),
+                         makeAssemblerLine(Instr::NUM, "D-4294967295"),
+                         makeAssemblerLine(Instr::NUM, "D5000000000"),
+                         makeAssemblerLine(Instr::NUM, "D-5000000000"),
+                         makeAssemblerLine(Instr::NUM, "XFFFFFFFFFF"));
+  optimize::foldConstants(seq);
+
+  REQUIRE( seq.size() == 9 );
+  REQUIRE( seq[0] == makeAssemblerLine(Instr::INT, 42L) );
+  REQUIRE( seq[1] == makeAssemblerLine(Instr::INT, -31L) );
+  // Values which need a big integer are left alone
+  REQUIRE( seq[2].getCommand() == Instr::NUM );
+  REQUIRE( seq[3].getCommand() == Instr::NUM );
+  REQUIRE( seq[4] == makeAssemblerLine(Instr::INT, 4294967295L) );
+  REQUIRE( seq[5] == makeAssemblerLine(Instr::INT, -4294967295L) );
+  // So are values wider than 32 bits, which a serialized `int`
+  // argument cannot hold
+  REQUIRE( seq[6].getCommand() == Instr::NUM );
+  REQUIRE( seq[7].getCommand() == Instr::NUM );
+  REQUIRE( seq[8].getCommand() == Instr::NUM );
+
+}
+
+TEST_CASE( "removeRedundantClears", "[optimize]" ) {
+
+  SECTION( "After a throa" ) {
+    InstrSeq seq = asmCode(makeAssemblerLine(Instr::ECLR),
+                           makeAssemblerLine(Instr::EXPD, Reg::NUM0),
+                           makeAssemblerLine(Instr::THROA, "Number expected"),
+                           makeAssemblerLine(Instr::ECLR),
+                           makeAssemblerLine(Instr::EXPD, Reg::NUM1),
+                           makeAssemblerLine(Instr::THROA, "Number expected"));
+    optimize::removeRedundantClears(seq);
+    REQUIRE( seq.size() == 5 );
+    REQUIRE( seq[0].getCommand() == Instr::ECLR );
+    REQUIRE( seq[3].getCommand() == Instr::EXPD );
+  }
+
+  SECTION( "Across instructions which may set %err0" ) {
+    InstrSeq seq = asmCode(makeAssemblerLine(Instr::ECLR),
+                           makeAssemblerLine(Instr::SYM, "foo"),
+                           makeAssemblerLine(Instr::ECLR),
+                           makeAssemblerLine(Instr::EXPD, Reg::SYM),
+                           makeAssemblerLine(Instr::ECLR),
+                           makeAssemblerLine(Instr::CPP, 0L),
+                           makeAssemblerLine(Instr::ECLR));
+    optimize::removeRedundantClears(seq);
+    REQUIRE( seq == asmCode(makeAssemblerLine(Instr::ECLR),
+                            makeAssemblerLine(Instr::SYM, "foo"),
+                            makeAssemblerLine(Instr::EXPD, Reg::SYM),
+                            makeAssemblerLine(Instr::ECLR),
+                            makeAssemblerLine(Instr::CPP, 0L),
+                            makeAssemblerLine(Instr::ECLR)) );
+  }
+
+}
+
+TEST_CASE( "fusePushPop", "[optimize]" ) {
+
+  SECTION( "Adjacent" ) {
+    InstrSeq seq = asmCode(makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                           makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO));
+    optimize::fusePushPop(seq);
+    REQUIRE( seq == asmCode(makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF)) );
+  }
+
+  SECTION( "Source overwritten in between" ) {
+    InstrSeq seq = asmCode(makeAssemblerLine(Instr::GETL, Reg::RET),
+                           makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                           makeAssemblerLine(Instr::YLDC, Lit::NUMBER, Reg::PTR),
+                           makeAssemblerLine(Instr::MOV, Reg::PTR, Reg::RET),
+                           makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO));
+    optimize::fusePushPop(seq);
+    REQUIRE( seq == asmCode(makeAssemblerLine(Instr::GETL, Reg::RET),
+                            makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                            makeAssemblerLine(Instr::YLDC, Lit::NUMBER, Reg::PTR),
+                            makeAssemblerLine(Instr::MOV, Reg::PTR, Reg::RET)) );
+  }
+
+  SECTION( "Blocked by a barrier or a use of the stack" ) {
+    InstrSeq seq1 = asmCode(makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                            makeAssemblerLine(Instr::RTRV),
+                            makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO));
+    InstrSeq seq2 = asmCode(makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                            makeAssemblerLine(Instr::PEEK, Reg::PTR, Reg::STO),
+                            makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO));
+    InstrSeq seq3 = asmCode(makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                            makeAssemblerLine(Instr::MOV, Reg::PTR, Reg::RET),
+                            makeAssemblerLine(Instr::MOV, Reg::SLF, Reg::PTR),
+                            makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO));
+    InstrSeq copy1 = seq1, copy2 = seq2, copy3 = seq3;
+    optimize::fusePushPop(seq1);
+    optimize::fusePushPop(seq2);
+    optimize::fusePushPop(seq3);
+    REQUIRE( seq1 == copy1 );
+    REQUIRE( seq2 == copy2 );
+    REQUIRE( seq3 == copy3 );
+  }
+
+}
+
+TEST_CASE( "removeRedundantMoves", "[optimize]" ) {
+
+  InstrSeq seq = asmCode(makeAssemblerLine(Instr::MOV, Reg::PTR, Reg::RET),
+                         makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                         makeAssemblerLine(Instr::MOV, Reg::SLF, Reg::SLF),
+                         makeAssemblerLine(Instr::CALL, 0L),
+                         makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR));
+  optimize::removeRedundantMoves(seq);
+  REQUIRE( seq == asmCode(makeAssemblerLine(Instr::MOV, Reg::PTR, Reg::RET),
+                          makeAssemblerLine(Instr::CALL, 0L),
+                          makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR)) );
+
+}
+
+TEST_CASE( "eliminateDeadRegisters", "[optimize]" ) {
+
+  InstrSeq seq = asmCode(makeAssemblerLine(Instr::INT, 1L),
+                         makeAssemblerLine(Instr::SYM, "a"),
+                         makeAssemblerLine(Instr::INT, 2L),
+                         makeAssemblerLine(Instr::SYM, "b"),
+                         makeAssemblerLine(Instr::YLDC, Lit::NUMBER, Reg::PTR),
+                         makeAssemblerLine(Instr::LOAD, Reg::NUM0),
+                         makeAssemblerLine(Instr::INT, 3L),
+                         makeAssemblerLine(Instr::CPP, 0L),
+                         makeAssemblerLine(Instr::INT, 4L));
+  optimize::eliminateDeadRegisters(seq);
+  // Writes are only dead if a later write happens before any read
+  // or barrier; everything is live at the end of the sequence.
+  REQUIRE( seq == asmCode(makeAssemblerLine(Instr::INT, 2L),
+                          makeAssemblerLine(Instr::SYM, "b"),
+                          makeAssemblerLine(Instr::YLDC, Lit::NUMBER, Reg::PTR),
+                          makeAssemblerLine(Instr::LOAD, Reg::NUM0),
+                          makeAssemblerLine(Instr::INT, 3L),
+                          makeAssemblerLine(Instr::CPP, 0L),
+                          makeAssemblerLine(Instr::INT, 4L)) );
+
+}
+
+TEST_CASE( "standardPipeline", "[optimize]" ) {
+
+  REQUIRE( optimize::standardPipeline(optimize::Level::NONE).size() == 0 );
+  REQUIRE( optimize::standardPipeline(optimize::Level::BASIC).size() <
+           optimize::standardPipeline(optimize::Level::FULL).size() );
+
+  // The translation of `x := 1.` at the top level
+  InstrSeq seq = asmCode(makeAssemblerLine(Instr::GETL, Reg::RET),
+                         makeAssemblerLine(Instr::PUSH, Reg::RET, Reg::STO),
+                         makeAssemblerLine(Instr::YLDC, Lit::NUMBER, Reg::PTR),
+                         makeAssemblerLine(Instr::NUM, "D1"),
+                         makeAssemblerLine(Instr::LOAD, Reg::NUM0),
+                         makeAssemblerLine(Instr::MOV, Reg::PTR, Reg::RET),
+                         makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                         makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                         makeAssemblerLine(Instr::SYM, "x"),
+                         makeAssemblerLine(Instr::SETF),
+                         makeAssemblerLine(Instr::MOV, Reg::PTR, Reg::RET));
+  TranslationUnitPtr unit = std::make_shared<TranslationUnit>(seq);
+  optimize::standardPipeline(optimize::Level::FULL).run(unit);
+  REQUIRE( unit->instructions() == asmCode(makeAssemblerLine(Instr::GETL, Reg::RET),
+                                           makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                           makeAssemblerLine(Instr::YLDC, Lit::NUMBER, Reg::PTR),
+                                           makeAssemblerLine(Instr::INT, 1L),
+                                           makeAssemblerLine(Instr::LOAD, Reg::NUM0),
+                                           makeAssemblerLine(Instr::MOV, Reg::PTR, Reg::RET),
+                                           makeAssemblerLine(Instr::SYM, "x"),
+                                           makeAssemblerLine(Instr::SETF),
+                                           makeAssemblerLine(Instr::MOV, Reg::PTR, Reg::RET)) );
+
+}
+
+TEST_CASE( "fuseInstructions", "[optimize]" ) {
+
+  InstrSeq seq = asmCode(makeAssemblerLine(Instr::GETD, Reg::SLF),
+                         makeAssemblerLine(Instr::SYMN, 10L),
+                         makeAssemblerLine(Instr::RTRV),
+                         makeAssemblerLine(Instr::SYMN, 11L),
+                         makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                         makeAssemblerLine(Instr::RTRV),
+                         makeAssemblerLine(Instr::MOV, Reg::RET, Reg::PTR),
+                         makeAssemblerLine(Instr::POP, Reg::SLF, Reg::STO),
+                         makeAssemblerLine(Instr::CALL, 0L),
+                         // Only exact matches are fused
+                         makeAssemblerLine(Instr::GETD, Reg::RET),
+                         makeAssemblerLine(Instr::SYMN, 12L),
+                         makeAssemblerLine(Instr::RTRV),
+                         makeAssemblerLine(Instr::SYM, "unresolved"),
+                         makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                         makeAssemblerLine(Instr::RTRV));
+  TranslationUnitPtr unit = std::make_shared<TranslationUnit>(seq);
+  optimize::fuseInstructions(unit);
+  REQUIRE( unit->instructions() == asmCode(makeAssemblerLine(Instr::ARGLD, 10L),
+                                           makeAssemblerLine(Instr::RTRVR, 11L),
+                                           makeAssemblerLine(Instr::CALLR, 0L),
+                                           makeAssemblerLine(Instr::GETD, Reg::RET),
+                                           makeAssemblerLine(Instr::SYMN, 12L),
+                                           makeAssemblerLine(Instr::RTRV),
+                                           makeAssemblerLine(Instr::SYM, "unresolved"),
+                                           makeAssemblerLine(Instr::MOV, Reg::RET, Reg::SLF),
+                                           makeAssemblerLine(Instr::RTRV)) );
+
+}
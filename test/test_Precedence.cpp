@@ -19,8 +19,7 @@ TEST_CASE( "Operator table", "" ) {
 
   ObjectPtr lex = clone(globalVM->reader.lit[Lit::OBJECT]);
   ObjectPtr meta = clone(globalVM->reader.lit[Lit::OBJECT]);
-  ObjectPtr obj = clone(globalVM->reader.lit[Lit::OBJECT]);
-  ObjectPtr impl = clone(globalVM->reader.lit[Lit::OBJECT]);
+  ObjectPtr obj = clone(globalVM->reader.lit[Lit::DICT]);
 
   eq->put(Symbols::get()["prec"], garnishObject(globalVM->reader, 5l));
   eq->put(Symbols::get()["assoc"], eq);
@@ -44,13 +43,13 @@ TEST_CASE( "Operator table", "" ) {
 
   lex->put(Symbols::get()["meta"], meta);
   meta->put(Symbols::get()["operators"], obj);
-  obj->put(Symbols::get()["&impl"], impl);
 
-  impl->put(Symbols::get()["=="], eq);
-  impl->put(Symbols::get()["+"], plus);
-  impl->put(Symbols::get()["-"], minus);
-  impl->put(Symbols::get()["*"], times);
-  impl->put(Symbols::get()["^"], pow);
+  DictStore& impl = boost::get<DictStore>(obj->prim());
+  impl.put(garnishObject(globalVM->reader, Symbols::get()["=="]), eq);
+  impl.put(garnishObject(globalVM->reader, Symbols::get()["+"]), plus);
+  impl.put(garnishObject(globalVM->reader, Symbols::get()["-"]), minus);
+  impl.put(garnishObject(globalVM->reader, Symbols::get()["*"]), times);
+  impl.put(garnishObject(globalVM->reader, Symbols::get()["^"]), pow);
 
   SECTION( "Getting the precedence table" ) {
 
@@ -70,6 +69,23 @@ TEST_CASE( "Operator table", "" ) {
 
   }
 
+  SECTION( "Operator table snapshots" ) {
+
+    OperatorTable table = getTable(lex);
+    REQUIRE( table.lookup("+").precedence == 10 );
+
+    // The snapshot keeps the value it first saw...
+    plus->put(Symbols::get()["prec"], garnishObject(globalVM->reader, 15l));
+    REQUIRE( table.lookup("+").precedence == 10 );
+    OperatorTable copy = table;
+    REQUIRE( copy.lookup("+").precedence == 10 );
+
+    // ... but a new table reflects the change.
+    OperatorTable table1 = getTable(lex);
+    REQUIRE( table1.lookup("+").precedence == 15 );
+
+  }
+
   SECTION( "Testing precedence" ) {
 
     // Original:
@@ -142,7 +158,7 @@ TEST_CASE( "Operator table", "" ) {
     // --- ---
 
     // Leaking memory, I think. The precedence code does some weird pointer stuff >.>
-    Expr* result = reorganizePrecedence(OperatorTable(impl), expr);
+    Expr* result = reorganizePrecedence(OperatorTable(obj), expr);
 
     //   ((1 + 2) - (3 * 4)) == 5.
     REQUIRE( strcmp(result->name, "==") == 0 );
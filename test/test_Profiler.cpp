@@ -0,0 +1,168 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#include "catch2/catch.hpp"
+#include "test.hpp"
+#include "Profiler.hpp"
+#include "Assembler.hpp"
+#include <cstdio>
+
+TEST_CASE( "Instruction names", "" ) {
+
+  REQUIRE( std::string(instructionName(Instr::MOV)) == "mov" );
+  REQUIRE( std::string(instructionName(Instr::CALL)) == "call" );
+  REQUIRE( std::string(instructionName(Instr::CALLR)) == "callr" );
+
+}
+
+TEST_CASE( "The instruction profiler counts executed instructions", "" ) {
+
+  InstrProfiler& profiler = InstrProfiler::get();
+  REQUIRE( !profiler.isEnabled() );
+
+  TranslationUnitPtr unit = std::make_shared<TranslationUnit>();
+  InstrSeq& seq = unit->instructions();
+  (makeAssemblerLine(Instr::LOCFN, std::string("profiled.lat"))).appendOnto(seq);
+  (makeAssemblerLine(Instr::LOCLN, 10L)).appendOnto(seq);
+  (makeAssemblerLine(Instr::ECLR)).appendOnto(seq);
+  (makeAssemblerLine(Instr::INT, 1L)).appendOnto(seq);
+  (makeAssemblerLine(Instr::LOCLN, 11L)).appendOnto(seq);
+  (makeAssemblerLine(Instr::ECLR)).appendOnto(seq);
+  (makeAssemblerLine(Instr::ECLR)).appendOnto(seq);
+
+  profiler.reset();
+  profiler.start("test_profile.tsv");
+  REQUIRE( profiler.isEnabled() );
+
+  // Run the code on an otherwise empty continuation, then restore the
+  // VM to its previous state.
+  MethodSeek oldCont = globalVM->state.cont;
+  NodePtr<MethodSeek> oldStack = globalVM->state.stack;
+  std::string oldFile = globalVM->state.file;
+  long oldLine = globalVM->state.line;
+  globalVM->state.cont = MethodSeek(Method(unit, { 0 }));
+  globalVM->state.stack = nullptr;
+  while (!isIdling(globalVM->state))
+    doOneStep(*globalVM);
+  globalVM->state.cont = oldCont;
+  globalVM->state.stack = oldStack;
+  globalVM->state.file = oldFile;
+  globalVM->state.line = oldLine;
+
+  REQUIRE( profiler.opcodeCounter(Instr::ECLR).count == 3 );
+  REQUIRE( profiler.opcodeCounter(Instr::INT).count == 1 );
+  REQUIRE( profiler.opcodeCounter(Instr::CALL).count == 0 );
+  // The instruction which changes the line is attributed to the
+  // line that was current when it began.
+  REQUIRE( profiler.lineCounter("profiled.lat", 10).count == 3 );
+  REQUIRE( profiler.lineCounter("profiled.lat", 11).count == 2 );
+
+  std::ostringstream oss;
+  profiler.writeReport(oss);
+  std::string report = oss.str();
+  REQUIRE( report.find("[opcodes]") != std::string::npos );
+  REQUIRE( report.find("\teclr\t3\t") != std::string::npos );
+  REQUIRE( report.find("[methods]") != std::string::npos );
+  REQUIRE( report.find("profiled.lat\t10\t0\t7\t") != std::string::npos );
+  REQUIRE( report.find("[lines]") != std::string::npos );
+
+  profiler.stop();
+  REQUIRE( !profiler.isEnabled() );
+  std::remove("test_profile.tsv");
+  profiler.reset();
+
+}
+
+TEST_CASE( "The sampling profiler records folded stacks", "" ) {
+
+  SamplingProfiler& profiler = SamplingProfiler::get();
+  profiler.reset();
+
+  IntState& state = globalVM->state;
+  NodePtr<BacktraceFrame> oldTrace = state.trace;
+  std::string oldFile = state.file;
+  long oldLine = state.line;
+
+  state.trace = nullptr;
+  state.file = "outer.lat";
+  state.line = 3;
+  pushTrace(state);
+  state.file = "inner;file.lat";
+  state.line = 7;
+
+  SamplingProfiler::pending = 1;
+  profiler.sample(*globalVM);
+  REQUIRE( SamplingProfiler::pending == 0 );
+
+  // Samples are discarded unless the profiler is running.
+  REQUIRE( profiler.sampleCount() == 0 );
+
+  REQUIRE( profiler.start("test_samples.txt") );
+  REQUIRE( profiler.isEnabled() );
+  profiler.sample(*globalVM);
+  profiler.sample(*globalVM);
+  popTrace(state);
+  profiler.sample(*globalVM);
+  REQUIRE( profiler.sampleCount() == 3 );
+
+  std::ostringstream oss;
+  profiler.writeFolded(oss);
+  REQUIRE( oss.str() == "outer.lat:3 1\nouter.lat:3;inner_file.lat:7 2\n" );
+
+  profiler.stop();
+  REQUIRE( !profiler.isEnabled() );
+  std::remove("test_samples.txt");
+  profiler.reset();
+
+  state.trace = oldTrace;
+  state.file = oldFile;
+  state.line = oldLine;
+
+}
+
+TEST_CASE( "The allocation profiler attributes objects to source lines", "" ) {
+
+  AllocationProfiler& profiler = AllocationProfiler::get();
+  profiler.reset();
+
+  IntState state;
+  state.file = "alloc.lat";
+  state.line = 4;
+
+  profiler.start("test_allocations.txt", state);
+  REQUIRE( profiler.isEnabled() );
+
+  ObjectPtr a = clone(globalVM->reader.lit[Lit::OBJECT]);
+  ObjectPtr b = clone(globalVM->reader.lit[Lit::OBJECT]);
+  state.line = 5;
+  ObjectPtr c = clone(globalVM->reader.lit[Lit::OBJECT]);
+
+  REQUIRE( profiler.totalAt("alloc.lat", 4) == 2 );
+  REQUIRE( profiler.liveAt("alloc.lat", 4) == 2 );
+  REQUIRE( profiler.totalAt("alloc.lat", 5) == 1 );
+
+  // Freed objects are no longer counted as live.
+  b = nullptr;
+  REQUIRE( profiler.totalAt("alloc.lat", 4) == 2 );
+  REQUIRE( profiler.liveAt("alloc.lat", 4) == 1 );
+
+  std::ostringstream oss;
+  profiler.writeReport(oss);
+  REQUIRE( oss.str().find("file\tline\tlive\ttotal\n") == 0 );
+  REQUIRE( oss.str().find("alloc.lat\t4\t1\t2\n") != std::string::npos );
+  REQUIRE( oss.str().find("alloc.lat\t5\t1\t1\n") != std::string::npos );
+
+  // Objects allocated before a reset are not charged to the new table.
+  profiler.reset();
+  state.line = 6;
+  ObjectPtr d = clone(globalVM->reader.lit[Lit::OBJECT]);
+  a = nullptr;
+  REQUIRE( profiler.liveAt("alloc.lat", 6) == 1 );
+  REQUIRE( profiler.liveAt("alloc.lat", 4) == 0 );
+
+  profiler.stop();
+  REQUIRE( !profiler.isEnabled() );
+  std::remove("test_allocations.txt");
+  profiler.reset();
+
+}
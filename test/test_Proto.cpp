@@ -6,6 +6,7 @@
 #include "Proto.hpp"
 #include "Protection.hpp"
 #include "GC.hpp"
+#include "Garnish.hpp"
 #include <boost/blank.hpp>
 
 TEST_CASE( "Accessing slots", "" ) {
@@ -144,3 +145,126 @@ TEST_CASE( "(Indirect) keys and hierarchy", "" ) {
   }
 
 }
+
+TEST_CASE( "Array storage", "" ) {
+
+  ObjectPtr arr0 = clone(globalVM->reader.lit[Lit::ARRAY]);
+  ObjectPtr elem = clone(globalVM->reader.lit[Lit::OBJECT]);
+  ArrayStore* store0 = boost::get<ArrayStore>(&arr0->prim());
+  REQUIRE( store0 != nullptr );
+  REQUIRE( store0->size() == 0 );
+
+  store0->elements().push_back(elem);
+  store0->elements().push_front(elem);
+  REQUIRE( store0->size() == 2 );
+
+  // Cloning shares the elements until one of the arrays is
+  // modified, so the two arrays are independent.
+  ObjectPtr arr1 = clone(arr0);
+  ArrayStore* store1 = boost::get<ArrayStore>(&arr1->prim());
+  const ArrayStore& view0 = *store0;
+  const ArrayStore& view1 = *store1;
+  REQUIRE( store1 != nullptr );
+  REQUIRE( *store1 == *store0 );
+  REQUIRE( &view1.elements() == &view0.elements() );
+  store1->elements().pop_back();
+  REQUIRE( &view1.elements() != &view0.elements() );
+  REQUIRE( store0->size() == 2 );
+  REQUIRE( store1->size() == 1 );
+  REQUIRE( !(*store1 == *store0) );
+
+}
+
+TEST_CASE( "Dictionary storage", "" ) {
+
+  ObjectPtr dict0 = clone(globalVM->reader.lit[Lit::DICT]);
+  ObjectPtr value = clone(globalVM->reader.lit[Lit::OBJECT]);
+  DictStore* store0 = boost::get<DictStore>(&dict0->prim());
+  REQUIRE( store0 != nullptr );
+  REQUIRE( store0->size() == 0 );
+
+  SECTION( "Strings, numbers, and symbols are compared by value" ) {
+    store0->put(garnishObject(globalVM->reader, std::string("abc")), value);
+    store0->put(garnishObject(globalVM->reader, 1l), value);
+    store0->put(garnishObject(globalVM->reader, Symbols::get()["foo"]), value);
+    REQUIRE( store0->size() == 3 );
+    REQUIRE( store0->get(garnishObject(globalVM->reader, std::string("abc"))) == value );
+    REQUIRE( store0->get(garnishObject(globalVM->reader, Number(1.0))) == value );
+    REQUIRE( store0->get(Symbols::get()["foo"]) == value );
+    REQUIRE( store0->get(garnishObject(globalVM->reader, std::string("foo"))) == nullptr );
+  }
+
+  SECTION( "Other objects are compared by identity" ) {
+    ObjectPtr key = clone(globalVM->reader.lit[Lit::OBJECT]);
+    store0->put(key, value);
+    REQUIRE( store0->get(key) == value );
+    REQUIRE( store0->get(clone(globalVM->reader.lit[Lit::OBJECT])) == nullptr );
+  }
+
+  SECTION( "Entries can be replaced and removed" ) {
+    for (long i = 0; i < 100; i++)
+      store0->put(garnishObject(globalVM->reader, i), garnishObject(globalVM->reader, i * i));
+    for (long i = 0; i < 100; i += 2)
+      REQUIRE( store0->remove(garnishObject(globalVM->reader, i)) );
+    REQUIRE( !store0->remove(garnishObject(globalVM->reader, 0l)) );
+    store0->put(garnishObject(globalVM->reader, 1l), value);
+    REQUIRE( store0->size() == 50 );
+    REQUIRE( store0->get(garnishObject(globalVM->reader, 1l)) == value );
+    REQUIRE( store0->get(garnishObject(globalVM->reader, 4l)) == nullptr );
+    // Keys are kept in insertion order.
+    std::vector<ObjectPtr> keys = store0->keys();
+    REQUIRE( keys.size() == 50 );
+    REQUIRE( boost::get<Number>(keys.front()->prim()) == Number(1l) );
+    REQUIRE( boost::get<Number>(keys.back()->prim()) == Number(99l) );
+  }
+
+  SECTION( "Cloning shares the entries until one dictionary is modified" ) {
+    ObjectPtr key = garnishObject(globalVM->reader, Symbols::get()["foo"]);
+    store0->put(key, value);
+    ObjectPtr dict1 = clone(dict0);
+    DictStore* store1 = boost::get<DictStore>(&dict1->prim());
+    REQUIRE( store1 != nullptr );
+    REQUIRE( *store1 == *store0 );
+    store1->put(garnishObject(globalVM->reader, Symbols::get()["bar"]), value);
+    REQUIRE( store0->size() == 1 );
+    REQUIRE( store1->size() == 2 );
+    REQUIRE( store0->get(Symbols::get()["bar"]) == nullptr );
+    store1->remove(key);
+    REQUIRE( store0->get(key) == value );
+    REQUIRE( store1->get(key) == nullptr );
+    REQUIRE( !(*store1 == *store0) );
+  }
+
+}
+
+TEST_CASE( "Byte buffers", "" ) {
+
+  ObjectPtr buf0 = clone(globalVM->reader.lit[Lit::BYTES]);
+  REQUIRE( boost::get<ByteBuffer>(&buf0->prim()) != nullptr );
+
+  ByteBuffer buffer { std::string("\x01\x02\xff\x80\x00", 5) };
+  REQUIRE( buffer.size() == 5 );
+  REQUIRE( buffer[2] == 0xFF );
+  REQUIRE( buffer.decode(0, 2, false) == 0x0201 );
+  REQUIRE( buffer.decode(0, 2, true) == 0x0102 );
+  REQUIRE( buffer.decode(2, 3, true) == 0xFF8000 );
+
+  SECTION( "Slices share the bytes of the original buffer" ) {
+    ByteBuffer slice = buffer.slice(1, 4);
+    REQUIRE( slice.size() == 3 );
+    REQUIRE( slice.data() == buffer.data() + 1 );
+    REQUIRE( slice[0] == 0x02 );
+    REQUIRE( slice.toString() == std::string("\x02\xff\x80") );
+    REQUIRE( slice.slice(1, 100) == buffer.slice(2, 4) );
+    REQUIRE( buffer.slice(4, 2).size() == 0 );
+  }
+
+  SECTION( "Buffers are compared by their bytes" ) {
+    REQUIRE( buffer == ByteBuffer(buffer.toString()) );
+    REQUIRE( !(buffer == buffer.slice(0, 4)) );
+    REQUIRE( buffer.slice(0, 4) < buffer );
+    REQUIRE( buffer.slice(0, 2) < buffer.slice(2, 3) );
+    REQUIRE( ByteBuffer() == buffer.slice(3, 3) );
+  }
+
+}
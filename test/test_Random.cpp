@@ -0,0 +1,67 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#include "catch2/catch.hpp"
+#include "test.hpp"
+#include "Random.hpp"
+#include <algorithm>
+
+TEST_CASE( "Pseudorandom generators", "" ) {
+
+  SECTION( "The generator matches the reference implementation" ) {
+    // The first outputs of xoshiro256** seeded by SplitMix64 from 0.
+    RandomGenerator gen { 0 };
+    REQUIRE( gen.next() == 0x99EC5F36CB75F2B4ULL );
+    REQUIRE( gen.next() == 0xBF6E1F784956452AULL );
+    REQUIRE( gen.next() == 0x1A5F849D4933E6E0ULL );
+  }
+
+  SECTION( "Equal seeds produce equal sequences" ) {
+    RandomGenerator first { 42 };
+    RandomGenerator second { 42 };
+    RandomGenerator third { 43 };
+    REQUIRE( first == second );
+    REQUIRE( !(first == third) );
+    for (int i = 0; i < 10; i++)
+      REQUIRE( first.next() == second.next() );
+    RandomGenerator copy = first;
+    REQUIRE( copy.next() == first.next() );
+  }
+
+  SECTION( "Bounded integers stay in range and cover it" ) {
+    RandomGenerator gen { 7 };
+    int counts[6] = { 0 };
+    bool inRange = true;
+    for (int i = 0; i < 6000; i++) {
+      std::uint64_t value = gen.nextBelow(6);
+      inRange = inRange && (value < 6);
+      if (value < 6)
+        ++counts[value];
+    }
+    REQUIRE( inRange );
+    for (int count : counts)
+      REQUIRE( count > 800 );
+    REQUIRE( gen.nextBelow(1) == 0 );
+    std::uint64_t big = (std::uint64_t(1) << 63) + 1;
+    bool bigInRange = true;
+    for (int i = 0; i < 100; i++)
+      bigInRange = bigInRange && (gen.nextBelow(big) < big);
+    REQUIRE( bigInRange );
+  }
+
+  SECTION( "Floating point values lie in the unit interval" ) {
+    RandomGenerator gen { 7 };
+    double total = 0.0, least = 1.0, greatest = 0.0;
+    for (int i = 0; i < 1000; i++) {
+      double value = gen.nextDouble();
+      least = std::min(least, value);
+      greatest = std::max(greatest, value);
+      total += value;
+    }
+    REQUIRE( least >= 0.0 );
+    REQUIRE( greatest < 1.0 );
+    REQUIRE( total > 400.0 );
+    REQUIRE( total < 600.0 );
+  }
+
+}
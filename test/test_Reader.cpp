@@ -0,0 +1,39 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#include "catch2/catch.hpp"
+#include "test.hpp"
+#include "Reader.hpp"
+#include "Base.hpp"
+
+TEST_CASE( "Streaming parser", "" ) {
+
+  // An empty operator table is sufficient for code with no operators.
+  OperatorTable table { clone(globalVM->reader.lit[Lit::OBJECT]) };
+
+  SECTION( "Statements are passed along in order" ) {
+    std::vector<int> lines;
+    parse(table, "(test)", "a.\nb c.\n\nd e: f.", [&lines](Stmt& stmt) {
+      lines.push_back(stmt.line());
+    });
+    REQUIRE( lines == std::vector<int>({ 1, 2, 4 }) );
+  }
+
+  SECTION( "Statements before a parse error are still emitted" ) {
+    int count = 0;
+    auto callback = [&count](Stmt&) { ++count; };
+    REQUIRE_THROWS_AS( parse(table, "(test)", "a.\nb.\nc (.", callback), ParseError );
+    REQUIRE( count == 2 );
+  }
+
+  SECTION( "The parse arena is reused across many statements" ) {
+    std::ostringstream oss;
+    for (int i = 0; i < 5000; i++)
+      oss << "foo bar: { baz. [1, 2, \"three\", 'four]. }.\n";
+    int count = 0;
+    parse(table, "(test)", oss.str(), [&count](Stmt&) { ++count; });
+    REQUIRE( count == 5000 );
+    REQUIRE( !inParseArena() );
+  }
+
+}
@@ -0,0 +1,144 @@
+//// Copyright (c) 2018 Silvio Mayolo
+//// See LICENSE.txt for licensing details
+
+#include "catch2/catch.hpp"
+#include "test.hpp"
+#include "Stream.hpp"
+#include "Process.hpp"
+#include "Platform.hpp"
+#include <cstdio>
+
+TEST_CASE( "Buffered file streams", "" ) {
+
+  const char* name = "test_stream.txt";
+
+  SECTION( "Lines are split as by getline" ) {
+    {
+      FileStream out { name, FileAccess::WRITE, FileMode::TEXT };
+      REQUIRE( out.hasOut() );
+      REQUIRE( !out.hasIn() );
+      out.writeLine("first");
+      out.writeText("second\r\n\nthird");
+    }
+    FileStream in { name, FileAccess::READ, FileMode::TEXT };
+    REQUIRE( in.hasIn() );
+    REQUIRE( in.readLine() == "first" );
+    REQUIRE( in.readLine() == "second\r" );
+    REQUIRE( in.readLine() == "" );
+    REQUIRE( !in.isEof() );
+    REQUIRE( in.readLine() == "third" );
+    REQUIRE( in.isEof() );
+  }
+
+  SECTION( "A trailing newline leaves one more empty line" ) {
+    {
+      FileStream out { name, FileAccess::WRITE, FileMode::TEXT };
+      out.writeLine("only");
+    }
+    FileStream in { name, FileAccess::READ, FileMode::TEXT };
+    REQUIRE( in.readLine() == "only" );
+    REQUIRE( !in.isEof() );
+    REQUIRE( in.readLine() == "" );
+    REQUIRE( in.isEof() );
+  }
+
+  SECTION( "Data larger than the buffer survives a round trip" ) {
+    std::string line(BufferedStream::BUFFER_SIZE * 2 + 17, 'x');
+    for (std::size_t i = 0; i < line.size(); i += 1000)
+      line[i] = 'a' + (i / 1000) % 26;
+    {
+      FileStream out { name, FileAccess::WRITE, FileMode::BINARY };
+      for (char ch : std::string("ab"))
+        out.out(ch);
+      out.writeLine(line);
+      out.writeText("tail");
+    }
+    FileStream in { name, FileAccess::READ, FileMode::BINARY };
+    REQUIRE( in.in() == 'a' );
+    REQUIRE( in.readText(1) == "b" );
+    REQUIRE( in.readLine() == line );
+    REQUIRE( in.readText(10) == "tail" );
+    REQUIRE( in.isEof() );
+  }
+
+  SECTION( "The rest of a file can be read at once" ) {
+    std::string data(BufferedStream::BUFFER_SIZE * 3, 'y');
+    {
+      FileStream out { name, FileAccess::WRITE, FileMode::BINARY };
+      out.writeLine("header");
+      out.writeText(data);
+    }
+    FileStream in { name, FileAccess::READ, FileMode::BINARY };
+    REQUIRE( in.readLine() == "header" );
+    REQUIRE( !in.isEof() );
+    REQUIRE( in.readAll() == data );
+    REQUIRE( in.isEof() );
+    REQUIRE( in.readAll() == "" );
+  }
+
+  SECTION( "Closing a stream removes its capabilities" ) {
+    FileStream out { name, FileAccess::WRITE, FileMode::TEXT };
+    out.writeText("unflushed");
+    out.close();
+    REQUIRE( !out.hasOut() );
+    REQUIRE( out.isEof() );
+    FileStream in { name, FileAccess::READ, FileMode::TEXT };
+    REQUIRE( in.readLine() == "unflushed" );
+  }
+
+  SECTION( "A file which cannot be opened is treated as closed" ) {
+    FileStream in { "nonexistent/test_stream.txt", FileAccess::READ, FileMode::TEXT };
+    REQUIRE( !in.hasIn() );
+    REQUIRE( in.isEof() );
+  }
+
+  std::remove(name);
+
+}
+
+#ifdef USE_POSIX
+
+TEST_CASE( "Subprocess pipes", "" ) {
+
+  SECTION( "Arguments are passed to the program verbatim" ) {
+    ProcessPtr proc = makeProcess(std::vector<std::string>({ "printf", "%s|%s\\n", "a b", "$HOME" }));
+    REQUIRE( proc->run() );
+    REQUIRE( proc->stdOut()->readLine() == "a b|$HOME" );
+    while (!proc->isDone()) {}
+    REQUIRE( proc->getExitCode() == 0 );
+  }
+
+  SECTION( "Shell commands see their input and report their exit codes" ) {
+    ProcessPtr proc = makeProcess("cat; exit 3");
+    REQUIRE( proc->run() );
+    proc->stdIn()->writeLine("first");
+    proc->stdIn()->writeText("second");
+    proc->stdIn()->close();
+    REQUIRE( proc->stdOut()->readLine() == "first" );
+    REQUIRE( proc->stdOut()->readLine() == "second" );
+    REQUIRE( proc->stdOut()->isEof() );
+    while (!proc->isDone()) {}
+    REQUIRE( proc->getExitCode() == 3 );
+  }
+
+  SECTION( "Several pipes can be waited on at once" ) {
+    ProcessPtr slow = makeProcess("sleep 5");
+    ProcessPtr fast = makeProcess("echo done");
+    REQUIRE( slow->run() );
+    REQUIRE( fast->run() );
+    std::vector<StreamPtr> streams { slow->stdOut(), fast->stdOut() };
+    REQUIRE( pollStreams(streams, -1) == std::vector<std::size_t>({ 1 }) );
+    REQUIRE( !slow->stdOut()->isReady() );
+    REQUIRE( fast->stdOut()->isReady() );
+    REQUIRE( fast->stdOut()->readLine() == "done" );
+    REQUIRE( pollStreams({ slow->stdOut() }, 10).empty() );
+  }
+
+  SECTION( "A missing program fails to start" ) {
+    ProcessPtr proc = makeProcess(std::vector<std::string>({ "no-such-program-for-latitude" }));
+    REQUIRE( !proc->run() );
+  }
+
+}
+
+#endif // USE_POSIX
@@ -105,3 +105,146 @@ TEST_CASE( "charAt and nextCharPos", "[unicode]" ) {
   REQUIRE( !charAt(str, *thirdCharPos) );
 
 }
+
+TEST_CASE( "Character positions in UTF-8 strings can be indexed", "[unicode]" ) {
+
+  SECTION( "ASCII strings need no offsets" ) {
+    std::string str(1000, 'x');
+    Utf8Index index { str };
+    REQUIRE( index.isValid() );
+    REQUIRE( index.isAscii() );
+    REQUIRE( index.length() == 1000 );
+    REQUIRE( index.byteOffset(str, 700) == 700 );
+    REQUIRE( index.charPos(str, 700) == 700 );
+  }
+
+  SECTION( "Offsets are correct across many strides" ) {
+    std::string alpha = UniChar(0x03b1);
+    std::string str(100, 'x');
+    for (int i = 0; i < 300; i++)
+      str += (i % 3 == 0) ? alpha : std::string("y");
+    Utf8Index index { str };
+    REQUIRE( index.isValid() );
+    REQUIRE( !index.isAscii() );
+    REQUIRE( index.length() == 400 );
+    std::size_t offset = 0;
+    for (std::size_t pos = 0; pos < index.length(); pos++) {
+      REQUIRE( index.byteOffset(str, pos) == offset );
+      REQUIRE( index.charPos(str, offset) == pos );
+      offset = *nextCharPos(str, offset);
+    }
+    REQUIRE( index.byteOffset(str, 400) == str.size() );
+    REQUIRE( index.charPos(str, str.size()) == 400 );
+    // An offset in the middle of a character rounds up to the next
+    // character.
+    REQUIRE( index.charPos(str, 101) == 101 );
+  }
+
+  SECTION( "Invalid strings are detected" ) {
+    std::string str(200, 'x');
+    str[150] = '\xC0';
+    REQUIRE( !Utf8Index(str).isValid() );
+  }
+
+  SECTION( "The cache rebuilds an index once its owner forgets it" ) {
+    int owner;
+    std::string str = "abc";
+    auto first = Utf8IndexCache::get().lookup(&owner, str);
+    REQUIRE( Utf8IndexCache::get().lookup(&owner, str) == first );
+    Utf8IndexCache::get().forget(&owner);
+    REQUIRE( Utf8IndexCache::get().lookup(&owner, str) != first );
+    Utf8IndexCache::get().forget(&owner);
+  }
+
+}
+
+TEST_CASE( "Every occurrence of a substring can be found", "[unicode]" ) {
+
+  using Offsets = std::vector<std::size_t>;
+
+  SECTION( "Short strings are searched" ) {
+    REQUIRE( findAllBytes("a,b,,c", ",", false) == Offsets({ 1, 3, 4 }) );
+    REQUIRE( findAllBytes("abc", "abcd", false).empty() );
+    REQUIRE( findAllBytes("abc", "", false).empty() );
+  }
+
+  SECTION( "Matches may optionally overlap" ) {
+    REQUIRE( findAllBytes("aaaa", "aa", false) == Offsets({ 0, 2 }) );
+    REQUIRE( findAllBytes("aaaa", "aa", true) == Offsets({ 0, 1, 2 }) );
+  }
+
+  SECTION( "Long strings agree with a naive search" ) {
+    std::string str;
+    for (int i = 0; i < 500; i++)
+      str += (i % 7 == 0) ? "ab" : (i % 5 == 0) ? "aab" : "xa";
+    for (std::string substr : { "a", "ab", "aab", "xaxa", "bxa" }) {
+      for (bool overlapping : { false, true }) {
+        Offsets expected;
+        std::size_t pos = str.find(substr);
+        while (pos != std::string::npos) {
+          expected.push_back(pos);
+          pos = str.find(substr, pos + (overlapping ? 1 : substr.size()));
+        }
+        REQUIRE( findAllBytes(str, substr, overlapping) == expected );
+      }
+    }
+  }
+
+}
+
+TEST_CASE( "Whole strings can be converted and classified", "[unicode]" ) {
+
+  SECTION( "Case conversion agrees with individual characters" ) {
+    std::string str = "The quick brown fox, \xC3\xA9t\xC3\xA9 and \xC7\x86, jumps over 12 lazy dogs!";
+    std::string upper, lower, title;
+    long pos = 0;
+    while (pos < (long)str.size()) {
+      UniChar ch = *charAt(str, pos);
+      upper += static_cast<std::string>(ch.toUpper());
+      lower += static_cast<std::string>(ch.toLower());
+      title += static_cast<std::string>(ch.toTitle());
+      pos = *nextCharPos(str, pos);
+    }
+    REQUIRE( convertCase(str, LetterCase::UPPER) == upper );
+    REQUIRE( convertCase(str, LetterCase::LOWER) == lower );
+    REQUIRE( convertCase(str, LetterCase::TITLE) == title );
+    REQUIRE( *convertCase("@[`{", LetterCase::UPPER) == "@[`{" );
+  }
+
+  SECTION( "Invalid strings cannot be converted" ) {
+    std::string str(40, 'a');
+    str[30] = '\xFF';
+    REQUIRE( !convertCase(str, LetterCase::UPPER) );
+  }
+
+  SECTION( "Byte strings are converted one ASCII letter at a time" ) {
+    std::string str = "abc\xFF\xC3\xA9xyz, and 0123456789 more bytes\x80";
+    REQUIRE( convertAsciiCase(str, LetterCase::UPPER) == "ABC\xFF\xC3\xA9XYZ, AND 0123456789 MORE BYTES\x80" );
+    REQUIRE( convertAsciiCase(str, LetterCase::TITLE) == convertAsciiCase(str, LetterCase::UPPER) );
+    REQUIRE( convertAsciiCase("@[`{ QRS", LetterCase::LOWER) == "@[`{ qrs" );
+  }
+
+  SECTION( "Spans of categories are counted in characters" ) {
+    unsigned long letters = (1UL << UNICLS_LU) | (1UL << UNICLS_LL);
+    REQUIRE( *categorySpan("abc123", letters) == 3 );
+    REQUIRE( *categorySpan("\xC3\xA9t\xC3\xA9!", letters) == 3 );
+    REQUIRE( *categorySpan("", letters) == 0 );
+    REQUIRE( *categorySpan("1\xFF", letters) == 0 );
+    REQUIRE( !categorySpan("a\xFF", letters) );
+    std::string longer(40, 'x');
+    REQUIRE( *categorySpan(longer, letters) == 40 );
+    longer[20] = '-';
+    REQUIRE( *categorySpan(longer, letters) == 20 );
+    longer[20] = 'x';
+    longer[35] = '\xFF';
+    REQUIRE( !categorySpan(longer, letters) );
+    REQUIRE( *categorySpan(std::string(33, 'x') + "\xC3\xA9" + std::string(20, 'y') + "!", letters) == 54 );
+  }
+
+  SECTION( "Categories are defined for every code point" ) {
+    REQUIRE( UniChar(0x41).genCat() == UNICLS_LU );
+    REQUIRE( UniChar(0x10FFFD).genCat() == UNICLS_CO );
+    REQUIRE( UniChar(0x110000).genCat() == UNICLS_CN );
+  }
+
+}